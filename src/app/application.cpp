@@ -66,6 +66,7 @@
 #endif
 
 #include "base/bittorrent/session.h"
+#include "base/bittorrent/torrentcreationmanager.h"
 #include "base/bittorrent/torrenthandle.h"
 #include "base/exceptions.h"
 #include "base/iconprovider.h"
@@ -564,6 +565,7 @@ int Application::exec(const QStringList &params)
         Net::GeoIPManager::initInstance();
 #endif
         ScanFoldersModel::initInstance();
+        BitTorrent::TorrentCreationManager::initInstance();
 
 #ifndef DISABLE_WEBUI
         m_webui = new WebUI;
@@ -752,6 +754,7 @@ void Application::cleanup()
     delete RSS::Session::instance();
 
     ScanFoldersModel::freeInstance();
+    BitTorrent::TorrentCreationManager::freeInstance();
     BitTorrent::Session::freeInstance();
 #ifndef DISABLE_COUNTRIES_RESOLUTION
     Net::GeoIPManager::freeInstance();
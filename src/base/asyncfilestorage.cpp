@@ -63,6 +63,17 @@ void AsyncFileStorage::store(const QString &fileName, const QByteArray &data)
 #endif
 }
 
+void AsyncFileStorage::append(const QString &fileName, const QByteArray &data)
+{
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+    QMetaObject::invokeMethod(this, [this, data, fileName]() { append_impl(fileName, data); }
+                              , Qt::QueuedConnection);
+#else
+    QMetaObject::invokeMethod(this, "append_impl", Qt::QueuedConnection
+                              , Q_ARG(QString, fileName), Q_ARG(QByteArray, data));
+#endif
+}
+
 QDir AsyncFileStorage::storageDir() const
 {
     return m_storageDir;
@@ -79,5 +90,29 @@ void AsyncFileStorage::store_impl(const QString &fileName, const QByteArray &dat
             qDebug() << "AsyncFileStorage: Failed to save data";
             emit failed(filePath, file.errorString());
         }
+        else {
+            emit stored(filePath);
+        }
+    }
+}
+
+void AsyncFileStorage::append_impl(const QString &fileName, const QByteArray &data)
+{
+    const QString filePath = m_storageDir.absoluteFilePath(fileName);
+    QFile file(filePath);
+    qDebug() << "AsyncFileStorage: Appending data to" << filePath;
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qDebug() << "AsyncFileStorage: Failed to append data";
+        emit failed(filePath, file.errorString());
+        return;
+    }
+
+    const qint64 oldSize = file.size();
+    if ((file.write(data) != data.size()) || !file.flush()) {
+        qDebug() << "AsyncFileStorage: Failed to append data";
+        const QString errorString = file.errorString();
+        // partially written data would break the following appended data
+        file.resize(oldSize);
+        emit failed(filePath, errorString);
     }
 }
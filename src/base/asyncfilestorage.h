@@ -50,14 +50,17 @@ public:
     ~AsyncFileStorage() override;
 
     void store(const QString &fileName, const QByteArray &data);
+    void append(const QString &fileName, const QByteArray &data);
 
     QDir storageDir() const;
 
 signals:
     void failed(const QString &fileName, const QString &errorString);
+    void stored(const QString &fileName);
 
 private:
     Q_INVOKABLE void store_impl(const QString &fileName, const QByteArray &data);
+    Q_INVOKABLE void append_impl(const QString &fileName, const QByteArray &data);
 
     QDir m_storageDir;
     QFile m_lockFile;
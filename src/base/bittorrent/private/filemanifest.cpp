@@ -0,0 +1,268 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2020  Eugene Shalygin <eugene.shalygin@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "filemanifest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QThread>
+
+#include "base/global.h"
+#include "base/logger.h"
+#include "base/utils/fs.h"
+#include "base/utils/string.h"
+
+namespace
+{
+    // Smaller levels of directory tree are scanned in the calling thread
+    const int MIN_PARALLEL_SCAN_DIRS = 16;
+
+    struct DirectoryScan
+    {
+        QString path;
+        qint64 lastModified = 0;
+        bool isSymLink = false;
+        QStringList filePaths;
+        QVector<qint64> fileSizes;
+        QStringList subdirPaths;
+        QVector<bool> isSubdirSymLink;
+    };
+
+    qint64 lastModified(const QFileInfo &info)
+    {
+        return info.lastModified().toMSecsSinceEpoch();
+    }
+
+    void scanDirectory(DirectoryScan &dirScan, const int relativePathOffset)
+    {
+        // hidden files are skipped
+        const QFileInfoList entries = QDir(dirScan.path).entryInfoList((QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot));
+
+        QVector<QPair<QString, qint64>> files;
+        for (const QFileInfo &entry : entries) {
+            if (entry.isDir()) {
+                dirScan.subdirPaths.append(entry.filePath());
+                dirScan.isSubdirSymLink.append(entry.isSymLink());
+            }
+            else {
+                files.append({entry.filePath().mid(relativePathOffset), entry.size()});
+            }
+        }
+
+        // need to sort the file names by natural sort order
+        std::sort(files.begin(), files.end(), [](const QPair<QString, qint64> &left, const QPair<QString, qint64> &right)
+        {
+            return Utils::String::naturalLessThan<Qt::CaseInsensitive>(left.first, right.first);
+        });
+
+        dirScan.filePaths.reserve(files.size());
+        dirScan.fileSizes.reserve(files.size());
+        for (const auto &file : files) {
+            dirScan.filePaths.append(file.first);
+            dirScan.fileSizes.append(file.second);
+        }
+    }
+
+    template <typename Func>
+    void parallelFor(const int count, Func func)
+    {
+        const int threadCount = std::min(QThread::idealThreadCount(), (count / MIN_PARALLEL_SCAN_DIRS));
+        if (threadCount <= 1) {
+            for (int i = 0; i < count; ++i)
+                func(i);
+            return;
+        }
+
+        std::atomic<int> nextIndex {0};
+        const auto work = [&nextIndex, count, &func]()
+        {
+            for (int i = nextIndex++; i < count; i = nextIndex++)
+                func(i);
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(threadCount - 1);
+        for (int i = 1; i < threadCount; ++i) {
+            try {
+                workers.emplace_back(work);
+            }
+            catch (const std::system_error &) {
+                // out of threads, do the rest here
+                break;
+            }
+        }
+        work();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+    std::mutex cachedManifestMutex;
+    std::shared_ptr<const FileManifest> cachedManifest;
+}
+
+std::shared_ptr<const FileManifest> FileManifest::load(const QString &inputPath)
+{
+    {
+        const std::lock_guard<std::mutex> lock {cachedManifestMutex};
+        if (cachedManifest && (cachedManifest->inputPath() == inputPath) && cachedManifest->isUpToDate())
+            return cachedManifest;
+    }
+
+    return rescan(inputPath);
+}
+
+std::shared_ptr<const FileManifest> FileManifest::rescan(const QString &inputPath)
+{
+    std::shared_ptr<FileManifest> manifest {new FileManifest};
+    manifest->scan(inputPath);
+
+    LogMsg(tr("Scanned \"%1\": %2 files in %3 directories, took %4 ms")
+        .arg(Utils::Fs::toNativePath(inputPath), QString::number(manifest->m_filePaths.size())
+            , QString::number(manifest->m_directoryCount), QString::number(manifest->m_scanDuration)));
+
+    const std::lock_guard<std::mutex> lock {cachedManifestMutex};
+    cachedManifest = manifest;
+    return manifest;
+}
+
+QString FileManifest::inputPath() const
+{
+    return m_inputPath;
+}
+
+QStringList FileManifest::filePaths() const
+{
+    return m_filePaths;
+}
+
+QVector<qint64> FileManifest::fileSizes() const
+{
+    return m_fileSizes;
+}
+
+qint64 FileManifest::totalSize() const
+{
+    return m_totalSize;
+}
+
+int FileManifest::directoryCount() const
+{
+    return m_directoryCount;
+}
+
+qint64 FileManifest::scanDuration() const
+{
+    return m_scanDuration;
+}
+
+bool FileManifest::isUpToDate() const
+{
+    // Adding, removing or renaming of an entry changes modification time of its directory
+    for (const auto &timestamp : m_timestamps) {
+        const QFileInfo info {timestamp.first};
+        if (!info.exists() || (lastModified(info) != timestamp.second))
+            return false;
+    }
+
+    return true;
+}
+
+void FileManifest::scan(const QString &inputPath)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    m_inputPath = inputPath;
+
+    const QFileInfo inputInfo {inputPath};
+    const int relativePathOffset = Utils::Fs::branchPath(inputPath).length() + 1;
+    if (!inputInfo.isDir()) {
+        m_filePaths = QStringList {inputInfo.fileName()};
+        m_fileSizes = {inputInfo.size()};
+        m_totalSize = inputInfo.size();
+        m_timestamps = {{inputPath, lastModified(inputInfo)}};
+        m_scanDuration = timer.elapsed();
+        return;
+    }
+
+    // Directory tree is scanned level by level, directories of each level in parallel
+    std::vector<DirectoryScan> dirScans;
+    std::vector<DirectoryScan> level(1);
+    level[0].path = inputPath;
+    while (!level.empty()) {
+        parallelFor(static_cast<int>(level.size()), [&level, relativePathOffset](const int i)
+        {
+            DirectoryScan &dirScan = level[i];
+            dirScan.lastModified = lastModified(QFileInfo(dirScan.path));
+            scanDirectory(dirScan, relativePathOffset);
+        });
+
+        std::vector<DirectoryScan> nextLevel;
+        for (DirectoryScan &dirScan : level) {
+            // contents of symlinked directories are included but they aren't traversed further
+            if (!dirScan.isSymLink) {
+                for (int i = 0; i < dirScan.subdirPaths.size(); ++i) {
+                    nextLevel.emplace_back();
+                    nextLevel.back().path = dirScan.subdirPaths[i];
+                    nextLevel.back().isSymLink = dirScan.isSubdirSymLink[i];
+                }
+            }
+
+            dirScans.push_back(std::move(dirScan));
+        }
+        level = std::move(nextLevel);
+    }
+
+    // need to sort the directories by natural sort order
+    std::sort(dirScans.begin(), dirScans.end(), [](const DirectoryScan &left, const DirectoryScan &right)
+    {
+        return Utils::String::naturalLessThan<Qt::CaseInsensitive>(left.path, right.path);
+    });
+
+    m_directoryCount = static_cast<int>(dirScans.size());
+    m_timestamps.reserve(m_directoryCount);
+    for (const DirectoryScan &dirScan : dirScans) {
+        m_filePaths.append(dirScan.filePaths);
+        m_fileSizes.append(dirScan.fileSizes);
+        m_timestamps.append({dirScan.path, dirScan.lastModified});
+    }
+
+    for (const qint64 fileSize : asConst(m_fileSizes))
+        m_totalSize += fileSize;
+
+    m_scanDuration = timer.elapsed();
+}
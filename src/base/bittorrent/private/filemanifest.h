@@ -0,0 +1,79 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2020  Eugene Shalygin <eugene.shalygin@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include <QCoreApplication>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Sorted list of the files a torrent is created from. Directories are scanned
+// once and the manifest is reused (e.g. by both piece count estimation and torrent
+// creation) until modification time of any scanned directory is changed. Files
+// modified in place don't change it, so their sizes must be checked when reading.
+class FileManifest
+{
+    Q_DECLARE_TR_FUNCTIONS(FileManifest)
+
+public:
+    // Returns the cached manifest if it's still up to date, otherwise scans the input path.
+    // Thread-safe.
+    static std::shared_ptr<const FileManifest> load(const QString &inputPath);
+    // Always scans the input path and replaces the cached manifest,
+    // e.g. if the sizes of the files don't match the cached ones.
+    // Thread-safe.
+    static std::shared_ptr<const FileManifest> rescan(const QString &inputPath);
+
+    QString inputPath() const;
+    // Paths are relative to the parent directory of the input path, in natural order
+    QStringList filePaths() const;
+    QVector<qint64> fileSizes() const;
+    qint64 totalSize() const;
+    int directoryCount() const;
+    // Duration of the scan which produced the manifest, in milliseconds
+    qint64 scanDuration() const;
+
+    bool isUpToDate() const;
+
+private:
+    FileManifest() = default;
+    void scan(const QString &inputPath);
+
+    QString m_inputPath;
+    QStringList m_filePaths;
+    QVector<qint64> m_fileSizes;
+    qint64 m_totalSize = 0;
+    int m_directoryCount = 0;
+    // Modification times of the scanned items, in milliseconds since epoch
+    QVector<QPair<QString, qint64>> m_timestamps;
+    qint64 m_scanDuration = 0;
+};
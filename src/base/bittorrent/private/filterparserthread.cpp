@@ -28,374 +28,443 @@
 
 #include "filterparserthread.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <cstring>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include <libtorrent/error_code.hpp>
+#include <libtorrent/version.hpp>
 
+#include <QCryptographicHash>
 #include <QDataStream>
+#include <QDateTime>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
 
 #include "base/logger.h"
-
-#include <boost/numeric/conversion/cast.hpp>
+#include "base/profile.h"
 
 namespace
 {
-    class IPv4Parser
+    enum class LineType
     {
-    public:
-        bool tryParse(const char *str)
-        {
-            unsigned char octetIndex = 0;
-
-            const char *octetStart = str;
-            char *endptr;
-            for (; *str; ++str) {
-                if (*str == '.') {
-                    const long int extractedNum = strtol(octetStart, &endptr, 10);
-                    if ((extractedNum >= 0L) && (extractedNum <= 255L))
-                        m_buf[octetIndex++] = static_cast<unsigned char>(extractedNum);
-                    else
-                        return false;
-
-                    if (endptr != str)
-                        return false;
-                    if (octetIndex == 4)
-                        return true;
-
-                    octetStart = str + 1;
-                }
-            }
+        Range,
+        Ignored,
+        Malformed
+    };
 
-            if (str != octetStart) {
-                const long int extractedNum = strtol(octetStart, &endptr, 10);
-                if ((extractedNum >= 0L) && (extractedNum <= 255L))
-                    m_buf[octetIndex] = static_cast<unsigned char>(strtol(octetStart, &endptr, 10));
-                else
-                    return false;
+    enum class ParseError
+    {
+        Malformed,
+        MalformedStartIP,
+        MalformedEndIP,
+        MixedIPVersions
+    };
 
-                if ((endptr == str) && (octetIndex == 3))
-                    return true;
-            }
+    // Part of the filter file (whole lines) and rules parsed from it
+    struct FilterChunk
+    {
+        const char *begin = nullptr;
+        const char *end = nullptr;
+
+        int lineCount = 0;
+        int ruleCount = 0;
+        int errorCount = 0;
+        std::vector<std::pair<int, ParseError>> errors;  // line in chunk, only first few are kept
+        std::vector<std::pair<quint32, quint32>> rangesV4;
+        std::vector<std::pair<lt::address_v6, lt::address_v6>> rangesV6;
+    };
 
-            return false;
-        }
+    using RangeExtractor = LineType (*)(const char *lineBegin, const char *lineEnd
+        , const char *&rangeBegin, const char *&rangeEnd);
 
-        lt::address_v4::bytes_type parsed() const
-        {
-            return m_buf;
-        }
+    const int MAX_LOGGED_ERRORS = 5;
 
-    private:
-        lt::address_v4::bytes_type m_buf;
-    };
+    // Parsed filter cache, consists of the header, sorted non-overlapping
+    // IPv4 ranges (pairs of quint32), IPv6 ranges (pairs of 16 bytes in
+    // network order) and UTF-8 encoded path of the source file.
+    const char FILTER_CACHE_FILENAME[] = "ipfilter.cache";
+    const char FILTER_CACHE_MAGIC[8] = {'Q', 'B', 'T', 'I', 'P', 'F', 'C', '\0'};
+    const quint32 FILTER_CACHE_VERSION = 1;
+    const quint32 FILTER_CACHE_BYTE_ORDER_MARK = 0x01020304;
 
-    bool parseIPAddress(const char *data, lt::address &address)
+    struct FilterCacheHeader
     {
-        IPv4Parser parser;
-        lt::error_code ec;
+        char magic[8];
+        quint32 version;
+        quint32 byteOrderMark;
+        qint64 sourceSize;
+        qint64 sourceLastModified;
+        char sourceHash[16];
+        qint32 ruleCount;
+        quint32 pathSize;
+        quint32 rangeCountV4;
+        quint32 rangeCountV6;
+    };
+    static_assert(sizeof(FilterCacheHeader) == 64, "Unexpected filter cache header layout");
 
-        if (parser.tryParse(data))
-            address = lt::address_v4(parser.parsed());
-        else
-            address = lt::address_v6::from_string(data, ec);
+    using IPv6Bytes = lt::address_v6::bytes_type;
+    static_assert(sizeof(IPv6Bytes) == 16, "Unexpected IPv6 address size");
+    // smaller chunks aren't worth a thread
+    const qint64 MIN_CHUNK_SIZE = 1024 * 1024; // 1 MiB
 
-        return !ec;
+    const char *findChar(const char *begin, const char *end, const char c)
+    {
+        // memchr() is vectorized by every sane libc
+        const void *pos = std::memchr(begin, c, static_cast<std::size_t>(end - begin));
+        return (pos != nullptr) ? static_cast<const char *>(pos) : end;
     }
 
-    const std::size_t BUFFER_SIZE = 2 * 1024 * 1024; // 2 MiB
-    const int MAX_LOGGED_ERRORS = 5;
-}
+    const char *findLastChar(const char *begin, const char *end, const char c)
+    {
+        for (const char *i = end; i > begin;) {
+            --i;
+            if (*i == c)
+                return i;
+        }
+        return end;
+    }
 
-FilterParserThread::FilterParserThread(QObject *parent)
-    : QThread(parent)
-    , m_abort(false)
-{
-}
+    void trim(const char *&begin, const char *&end)
+    {
+        while ((begin < end) && (std::isspace(static_cast<unsigned char>(*begin)) != 0))
+            ++begin;
+        while ((end > begin) && (std::isspace(static_cast<unsigned char>(*(end - 1))) != 0))
+            --end;
+    }
 
-FilterParserThread::~FilterParserThread()
-{
-    m_abort = true;
-    wait();
-}
+    // Behaves like strtol() on a non null-terminated string
+    long parseLong(const char *begin, const char *end)
+    {
+        trim(begin, end);
 
-// Parser for eMule ip filter in DAT format
-int FilterParserThread::parseDATFilterFile()
-{
-    int ruleCount = 0;
-    QFile file(m_filePath);
-    if (!file.exists()) return ruleCount;
+        bool negative = false;
+        if ((begin < end) && ((*begin == '-') || (*begin == '+'))) {
+            negative = (*begin == '-');
+            ++begin;
+        }
 
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        LogMsg(tr("I/O Error: Could not open IP filter file in read mode."), Log::CRITICAL);
-        return ruleCount;
+        long value = 0;
+        for (; (begin < end) && (*begin >= '0') && (*begin <= '9'); ++begin) {
+            value = (value * 10) + (*begin - '0');
+            if (value > 0xFFFF)  // only small values are of interest
+                break;
+        }
+        return (negative ? -value : value);
     }
 
-    std::vector<char> buffer(BUFFER_SIZE, 0); // seems a bit faster than QVector
-    qint64 bytesRead = 0;
-    std::size_t offset = 0;
-    char* start = nullptr;
-    char* endOfLine = nullptr;
-    int nbLine = 0;
-    int parseErrorCount = 0;
-    const auto addLog = [&parseErrorCount](const QString &msg)
+    bool parseIPv4(const char *begin, const char *end, quint32 &address)
     {
-        if (parseErrorCount <= MAX_LOGGED_ERRORS)
-            LogMsg(msg, Log::CRITICAL);
-    };
-
-    while (true) {
-        bytesRead = file.read(buffer.data() + offset, boost::numeric_cast<qint64>(BUFFER_SIZE - offset - 1));
-        if (bytesRead < 0)
-            break;
-        const std::size_t dataSize = boost::numeric_cast<std::size_t>(bytesRead) + offset;
-        if (bytesRead == 0 && dataSize == 0)
-            break;
-
-        for (start = &buffer[0]; start < &buffer[dataSize]; ++start) {
-            endOfLine = nullptr;
-            // The file might have ended without the last line having a newline
-            if (!(bytesRead == 0 && dataSize > 0)) {
-                for (char* pi = start; pi < &buffer[dataSize]; ++pi) {
-                    if (*pi == '\n') {
-                        endOfLine = pi;
-                        // We need to NULL the newline in case the line has only an IP range.
-                        // In that case the parser won't work for the end IP, because it ends
-                        // with the newline and not with a number.
-                        *pi = '\0';
-                        break;
-                    }
-                }
-            }
-            else {
-                endOfLine = &buffer[dataSize];
-                buffer[dataSize] = '\0';
+        quint32 result = 0;
+        for (int octetIndex = 0; octetIndex < 4; ++octetIndex) {
+            if (octetIndex > 0) {
+                if ((begin == end) || (*begin != '.'))
+                    return false;
+                ++begin;
             }
 
-            if (endOfLine == nullptr) {
-                // read the next chunk from file
-                // but first move(copy) the leftover data to the front of the buffer
-                offset = boost::numeric_cast<std::size_t>(&buffer[dataSize] - start);
-                memmove(buffer.data(), start, offset);
-                break;
+            const char *octetBegin = begin;
+            uint octet = 0;
+            for (; (begin < end) && (*begin >= '0') && (*begin <= '9'); ++begin) {
+                octet = (octet * 10) + static_cast<uint>(*begin - '0');
+                if (octet > 255)
+                    return false;
             }
+            if (begin == octetBegin)
+                return false;
 
-            ++nbLine;
+            result = (result << 8) | octet;
+        }
 
-            if ((*start == '#')
-                || ((*start == '/') && ((start + 1 < &buffer[dataSize]) && (*(start + 1) == '/')))) {
-                start = endOfLine;
-                continue;
-            }
+        if (begin != end)
+            return false;
+
+        address = result;
+        return true;
+    }
+
+    bool parseIPAddress(const char *begin, const char *end, lt::address &address)
+    {
+        trim(begin, end);
+        if (begin == end)
+            return false;
+
+        quint32 ipv4 = 0;
+        if (parseIPv4(begin, end, ipv4)) {
+            address = lt::address_v4(ipv4);
+            return true;
+        }
 
-            // Each line should follow this format:
-            // 001.009.096.105 - 001.009.096.105 , 000 , Some organization
-            // The 3rd entry is access level and if above 127 the IP range isn't blocked.
-            char* firstComma = findAndNullDelimiter(',', start, endOfLine);
-            if (firstComma != nullptr)
-                findAndNullDelimiter(',', firstComma + 1, endOfLine);
+        lt::error_code ec;
+        address = lt::address_v6::from_string(std::string(begin, end), ec);
+        return !ec;
+    }
 
+    // eMule DAT format:
+    // 001.009.096.105 - 001.009.096.105 , 000 , Some organization
+    // The 2nd entry is access level and if above 127 the IP range isn't blocked.
+    LineType extractDATRange(const char *lineBegin, const char *lineEnd, const char *&rangeBegin, const char *&rangeEnd)
+    {
+        const char *firstComma = findChar(lineBegin, lineEnd, ',');
+        if (firstComma != lineEnd) {
             // Check if there is an access value (apparently not mandatory)
-            if (firstComma != nullptr) {
-                // There is possibly one
-                const long int nbAccess = strtol(firstComma + 1, nullptr, 10);
-                // Ignoring this rule because access value is too high
-                if (nbAccess > 127L) {
-                    start = endOfLine;
-                    continue;
-                }
+            const char *secondComma = findChar((firstComma + 1), lineEnd, ',');
+            // Ignoring this rule because access value is too high
+            if (parseLong((firstComma + 1), secondComma) > 127L)
+                return LineType::Ignored;
+        }
+
+        rangeBegin = lineBegin;
+        rangeEnd = firstComma;
+        return LineType::Range;
+    }
+
+    // PeerGuardian P2P format:
+    // Some organization:1.0.0.0-1.255.255.255
+    // The "Some organization" part might contain a ':' char itself so we find the last occurrence
+    LineType extractP2PRange(const char *lineBegin, const char *lineEnd, const char *&rangeBegin, const char *&rangeEnd)
+    {
+        const char *partsDelimiter = findLastChar(lineBegin, lineEnd, ':');
+        if (partsDelimiter == lineEnd)
+            return LineType::Malformed;
+
+        rangeBegin = partsDelimiter + 1;
+        rangeEnd = lineEnd;
+        return LineType::Range;
+    }
+
+    void parseChunk(FilterChunk &chunk, const RangeExtractor extractRange, const std::atomic<bool> &abort)
+    {
+        const auto addError = [&chunk](const ParseError error)
+        {
+            ++chunk.errorCount;
+            if (static_cast<int>(chunk.errors.size()) < MAX_LOGGED_ERRORS)
+                chunk.errors.emplace_back(chunk.lineCount, error);
+        };
+
+        const char *lineBegin = chunk.begin;
+        while ((lineBegin < chunk.end) && !abort) {
+            const char *lineEnd = findChar(lineBegin, chunk.end, '\n');
+            const char *nextLine = (lineEnd < chunk.end) ? (lineEnd + 1) : lineEnd;
+            ++chunk.lineCount;
+
+            const char *contentBegin = lineBegin;
+            const char *contentEnd = lineEnd;
+            trim(contentBegin, contentEnd);
+            lineBegin = nextLine;
+
+            // skip blank lines and comments
+            if ((contentBegin == contentEnd) || (*contentBegin == '#')
+                || ((*contentBegin == '/') && ((contentBegin + 1) < contentEnd) && (*(contentBegin + 1) == '/'))) {
+                continue;
+            }
+
+            const char *rangeBegin = nullptr;
+            const char *rangeEnd = nullptr;
+            const LineType lineType = extractRange(contentBegin, contentEnd, rangeBegin, rangeEnd);
+            if (lineType == LineType::Ignored)
+                continue;
+            if (lineType == LineType::Malformed) {
+                addError(ParseError::Malformed);
+                continue;
             }
 
             // IP Range should be split by a dash
-            char* endOfIPRange = ((firstComma == nullptr) ? (endOfLine - 1) : (firstComma - 1));
-            char* delimIP = findAndNullDelimiter('-', start, endOfIPRange);
-            if (delimIP == nullptr) {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed.").arg(nbLine));
-                start = endOfLine;
+            const char *delimIP = findChar(rangeBegin, rangeEnd, '-');
+            if (delimIP == rangeEnd) {
+                addError(ParseError::Malformed);
                 continue;
             }
 
             lt::address startAddr;
-            char* newStart = trim(start, delimIP - 1);
-            if (!parseIPAddress(newStart, startAddr)) {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed. Start IP of the range is malformed.").arg(nbLine));
-                start = endOfLine;
+            if (!parseIPAddress(rangeBegin, delimIP, startAddr)) {
+                addError(ParseError::MalformedStartIP);
                 continue;
             }
 
             lt::address endAddr;
-            newStart = trim(delimIP + 1, endOfIPRange);
-            if (!parseIPAddress(newStart, endAddr)) {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed. End IP of the range is malformed.").arg(nbLine));
-                start = endOfLine;
+            if (!parseIPAddress((delimIP + 1), rangeEnd, endAddr)) {
+                addError(ParseError::MalformedEndIP);
                 continue;
             }
 
-            if ((startAddr.is_v4() != endAddr.is_v4())
-                || (startAddr.is_v6() != endAddr.is_v6())) {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed. One IP is IPv4 and the other is IPv6!").arg(nbLine));
-                start = endOfLine;
+            if (startAddr.is_v4() != endAddr.is_v4()) {
+                addError(ParseError::MixedIPVersions);
                 continue;
             }
 
-            start = endOfLine;
+            if (endAddr < startAddr) {
+                addError(ParseError::Malformed);
+                continue;
+            }
 
-            // Now Add to the filter
-            try {
-                m_filter.add_rule(startAddr, endAddr, lt::ip_filter::blocked);
-                ++ruleCount;
+            if (startAddr.is_v4()) {
+                chunk.rangesV4.emplace_back(static_cast<quint32>(startAddr.to_v4().to_ulong())
+                    , static_cast<quint32>(endAddr.to_v4().to_ulong()));
             }
-            catch (const std::exception &e) {
-                ++parseErrorCount;
-                addLog(tr("IP filter exception thrown for line %1. Exception is: %2")
-                       .arg(nbLine).arg(QString::fromLocal8Bit(e.what())));
+            else {
+                chunk.rangesV6.emplace_back(startAddr.to_v6(), endAddr.to_v6());
             }
+            ++chunk.ruleCount;
         }
-
-        if (start >= &buffer[dataSize])
-            offset = 0;
     }
 
-    if (parseErrorCount > MAX_LOGGED_ERRORS)
-        LogMsg(tr("%1 extra IP filter parsing errors occurred.", "513 extra IP filter parsing errors occurred.")
-               .arg(parseErrorCount - MAX_LOGGED_ERRORS), Log::CRITICAL);
-    return ruleCount;
-}
+    // Splits data into (at most) `count` chunks at line boundaries
+    std::vector<FilterChunk> splitToChunks(const char *data, const qint64 size, const int count)
+    {
+        std::vector<FilterChunk> chunks;
+        chunks.reserve(count);
+
+        const char *end = data + size;
+        const char *chunkBegin = data;
+        for (int i = 1; (i <= count) && (chunkBegin < end); ++i) {
+            const char *chunkEnd = end;
+            if (i < count) {
+                const char *nominalEnd = data + ((size / count) * i);
+                chunkEnd = (nominalEnd > chunkBegin) ? findChar(nominalEnd, end, '\n') : chunkBegin;
+                if (chunkEnd < end)
+                    ++chunkEnd;
+            }
+            if (chunkEnd == chunkBegin)
+                continue;
 
-// Parser for PeerGuardian ip filter in p2p format
-int FilterParserThread::parseP2PFilterFile()
-{
-    int ruleCount = 0;
-    QFile file(m_filePath);
-    if (!file.exists()) return ruleCount;
+            FilterChunk chunk;
+            chunk.begin = chunkBegin;
+            chunk.end = chunkEnd;
+            chunks.push_back(std::move(chunk));
+            chunkBegin = chunkEnd;
+        }
 
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        LogMsg(tr("I/O Error: Could not open IP filter file in read mode."), Log::CRITICAL);
-        return ruleCount;
+        return chunks;
     }
 
-    std::vector<char> buffer(BUFFER_SIZE, 0); // seems a bit faster than QVector
-    qint64 bytesRead = 0;
-    std::size_t offset = 0;
-    char* start = nullptr;
-    char* endOfLine = nullptr;
-    int nbLine = 0;
-    int parseErrorCount = 0;
-    const auto addLog = [&parseErrorCount](const QString &msg)
+    // Sorts the ranges and joins overlapping and adjacent ones
+    std::vector<std::pair<quint32, quint32>> mergeRanges(std::vector<std::pair<quint32, quint32>> ranges)
     {
-        if (parseErrorCount <= MAX_LOGGED_ERRORS)
-            LogMsg(msg, Log::CRITICAL);
-    };
+        std::sort(ranges.begin(), ranges.end());
 
-    while (true) {
-        bytesRead = file.read(buffer.data() + offset, boost::numeric_cast<qint64>(BUFFER_SIZE - offset - 1));
-        if (bytesRead < 0)
-            break;
-        const std::size_t dataSize = boost::numeric_cast<std::size_t>(bytesRead) + offset;
-        if (bytesRead == 0 && dataSize == 0)
-            break;
-
-        for (start = &buffer.front(); start < &buffer[dataSize]; ++start) {
-            endOfLine = nullptr;
-            // The file might have ended without the last line having a newline
-            if (!(bytesRead == 0 && dataSize > 0)) {
-                for (char* i = start; i < &buffer[dataSize]; ++i) {
-                    if (*i == '\n') {
-                        endOfLine = i;
-                        // We need to NULL the newline in case the line has only an IP range.
-                        // In that case the parser won't work for the end IP, because it ends
-                        // with the newline and not with a number.
-                        *i = '\0';
-                        break;
-                    }
-                }
+        std::vector<std::pair<quint32, quint32>> merged;
+        merged.reserve(ranges.size());
+        for (const auto &range : ranges) {
+            if (!merged.empty() && ((merged.back().second == 0xFFFFFFFF)
+                || (range.first <= (merged.back().second + 1)))) {
+                merged.back().second = std::max(merged.back().second, range.second);
             }
             else {
-                endOfLine = &buffer[dataSize];
-                buffer[dataSize] = '\0';
+                merged.push_back(range);
             }
+        }
 
-            if (endOfLine == nullptr) {
-                // read the next chunk from file
-                // but first move(copy) the leftover data to the front of the buffer
-                offset = boost::numeric_cast<std::size_t>(&buffer[dataSize] - start);
-                memmove(buffer.data(), start, offset);
-                break;
-            }
+        return merged;
+    }
+}
 
-            ++nbLine;
+FilterParserThread::FilterParserThread(QObject *parent)
+    : QThread(parent)
+    , m_abort(false)
+{
+}
 
-            if ((*start == '#')
-                || ((*start == '/') && ((start + 1 < &buffer[dataSize]) && (*(start + 1) == '/')))) {
-                start = endOfLine;
-                continue;
-            }
+FilterParserThread::~FilterParserThread()
+{
+    m_abort = true;
+    wait();
+}
 
-            // Each line should follow this format:
-            // Some organization:1.0.0.0-1.255.255.255
-            // The "Some organization" part might contain a ':' char itself so we find the last occurrence
-            char* partsDelimiter = findAndNullDelimiter(':', start, endOfLine, true);
-            if (partsDelimiter == nullptr) {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed.").arg(nbLine));
-                start = endOfLine;
-                continue;
-            }
+// Parser for eMule ip filter in DAT format and PeerGuardian ip filter in p2p format
+// The file is memory mapped and split into chunks which are parsed in parallel
+int FilterParserThread::parseTextFilterFile(const TextFilterFormat format)
+{
+    QFile file(m_filePath);
+    if (!file.exists()) return 0;
 
-            // IP Range should be split by a dash
-            char* delimIP = findAndNullDelimiter('-', partsDelimiter + 1, endOfLine);
-            if (delimIP == nullptr) {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed.").arg(nbLine));
-                start = endOfLine;
-                continue;
-            }
+    if (!file.open(QIODevice::ReadOnly)) {
+        LogMsg(tr("I/O Error: Could not open IP filter file in read mode."), Log::CRITICAL);
+        return 0;
+    }
 
-            lt::address startAddr;
-            char* newStart = trim(partsDelimiter + 1, delimIP - 1);
-            if (!parseIPAddress(newStart, startAddr)) {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed. Start IP of the range is malformed.").arg(nbLine));
-                start = endOfLine;
-                continue;
-            }
+    const qint64 fileSize = file.size();
+    if (fileSize <= 0) return 0;
 
-            lt::address endAddr;
-            newStart = trim(delimIP + 1, endOfLine);
-            if (!parseIPAddress(newStart, endAddr)) {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed. End IP of the range is malformed.").arg(nbLine));
-                start = endOfLine;
-                continue;
-            }
+    QByteArray fileData;
+    const char *data = reinterpret_cast<const char *>(file.map(0, fileSize));
+    if (data == nullptr) {
+        // mapping isn't supported for this file, fall back to reading it
+        fileData = file.readAll();
+        data = fileData.constData();
+    }
 
-            if ((startAddr.is_v4() != endAddr.is_v4())
-                || (startAddr.is_v6() != endAddr.is_v6())) {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed. One IP is IPv4 and the other is IPv6!").arg(nbLine));
-                start = endOfLine;
-                continue;
-            }
+    const int threadCount = std::max(1, std::min(QThread::idealThreadCount()
+        , static_cast<int>(std::min<qint64>((fileSize / MIN_CHUNK_SIZE), 64))));
+    std::vector<FilterChunk> chunks = splitToChunks(data, fileSize, threadCount);
+
+    const RangeExtractor extractRange = (format == TextFilterFormat::DAT) ? extractDATRange : extractP2PRange;
+    std::vector<std::thread> workers;
+    workers.reserve(chunks.size());
+    for (std::size_t i = 1; i < chunks.size(); ++i) {
+        try {
+            workers.emplace_back(parseChunk, std::ref(chunks[i]), extractRange, std::cref(m_abort));
+        }
+        catch (const std::system_error &) {
+            // out of threads, parse it here
+            parseChunk(chunks[i], extractRange, m_abort);
+        }
+    }
+    if (!chunks.empty())
+        parseChunk(chunks[0], extractRange, m_abort);
+    for (std::thread &worker : workers)
+        worker.join();
 
-            start = endOfLine;
+    if (m_abort) return 0;
 
-            try {
-                m_filter.add_rule(startAddr, endAddr, lt::ip_filter::blocked);
-                ++ruleCount;
-            }
-            catch (const std::exception &e) {
-                ++parseErrorCount;
-                addLog(tr("IP filter exception thrown for line %1. Exception is: %2")
-                       .arg(nbLine).arg(QString::fromLocal8Bit(e.what())));
+    int ruleCount = 0;
+    int parseErrorCount = 0;
+    int loggedErrorCount = 0;
+    int lineOffset = 0;
+    std::vector<std::pair<quint32, quint32>> rangesV4;
+    for (FilterChunk &chunk : chunks) {
+        for (const auto &error : chunk.errors) {
+            if (loggedErrorCount >= MAX_LOGGED_ERRORS)
+                break;
+            ++loggedErrorCount;
+
+            const int nbLine = lineOffset + error.first;
+            switch (error.second) {
+            case ParseError::Malformed:
+                LogMsg(tr("IP filter line %1 is malformed.").arg(nbLine), Log::CRITICAL);
+                break;
+            case ParseError::MalformedStartIP:
+                LogMsg(tr("IP filter line %1 is malformed. Start IP of the range is malformed.").arg(nbLine), Log::CRITICAL);
+                break;
+            case ParseError::MalformedEndIP:
+                LogMsg(tr("IP filter line %1 is malformed. End IP of the range is malformed.").arg(nbLine), Log::CRITICAL);
+                break;
+            case ParseError::MixedIPVersions:
+                LogMsg(tr("IP filter line %1 is malformed. One IP is IPv4 and the other is IPv6!").arg(nbLine), Log::CRITICAL);
+                break;
             }
         }
+        parseErrorCount += chunk.errorCount;
 
-        if (start >= &buffer[dataSize])
-            offset = 0;
+        lineOffset += chunk.lineCount;
+        ruleCount += chunk.ruleCount;
+        rangesV4.insert(rangesV4.end(), chunk.rangesV4.cbegin(), chunk.rangesV4.cend());
+        std::vector<std::pair<quint32, quint32>>().swap(chunk.rangesV4);
+    }
+
+    // Now Add to the filter
+    for (const auto &range : mergeRanges(std::move(rangesV4)))
+        m_filter.add_rule(lt::address_v4(range.first), lt::address_v4(range.second), lt::ip_filter::blocked);
+    for (const FilterChunk &chunk : chunks) {
+        for (const auto &range : chunk.rangesV6)
+            m_filter.add_rule(range.first, range.second, lt::ip_filter::blocked);
     }
 
     if (parseErrorCount > MAX_LOGGED_ERRORS)
@@ -534,6 +603,179 @@ int FilterParserThread::parseP2BFilterFile()
     return ruleCount;
 }
 
+FilterParserThread::SourceFingerprint FilterParserThread::sourceFingerprint() const
+{
+    const QFileInfo fileInfo {m_filePath};
+    SourceFingerprint fingerprint;
+    fingerprint.path = fileInfo.absoluteFilePath();
+    fingerprint.size = fileInfo.size();
+    fingerprint.lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+    return fingerprint;
+}
+
+QByteArray FilterParserThread::sourceHash() const
+{
+    QFile file {m_filePath};
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+
+    QCryptographicHash hash {QCryptographicHash::Md5};
+    if (!hash.addData(&file))
+        return {};
+
+    return hash.result();
+}
+
+bool FilterParserThread::loadFilterCache(SourceFingerprint &fingerprint, int &ruleCount)
+{
+    QFile file {QDir(specialFolderLocation(SpecialFolder::Cache)).absoluteFilePath(FILTER_CACHE_FILENAME)};
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 fileSize = file.size();
+    if (fileSize < static_cast<qint64>(sizeof(FilterCacheHeader)))
+        return false;
+
+    QByteArray fileData;
+    const char *data = reinterpret_cast<const char *>(file.map(0, fileSize));
+    if (data == nullptr) {
+        fileData = file.readAll();
+        if (fileData.size() != fileSize)
+            return false;
+        data = fileData.constData();
+    }
+
+    // validate it
+    FilterCacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if ((std::memcmp(header.magic, FILTER_CACHE_MAGIC, sizeof(header.magic)) != 0)
+        || (header.version != FILTER_CACHE_VERSION)
+        || (header.byteOrderMark != FILTER_CACHE_BYTE_ORDER_MARK))
+        return false;
+
+    const qint64 expectedSize = static_cast<qint64>(sizeof(header))
+        + (static_cast<qint64>(header.rangeCountV4) * 2 * sizeof(quint32))
+        + (static_cast<qint64>(header.rangeCountV6) * 2 * sizeof(IPv6Bytes))
+        + header.pathSize;
+    if (fileSize != expectedSize)
+        return false;
+
+    const char *rangesV4 = data + sizeof(header);
+    const char *rangesV6 = rangesV4 + (static_cast<qint64>(header.rangeCountV4) * 2 * sizeof(quint32));
+    const char *path = rangesV6 + (static_cast<qint64>(header.rangeCountV6) * 2 * sizeof(IPv6Bytes));
+
+    if ((header.sourceSize != fingerprint.size)
+        || (header.sourceLastModified != fingerprint.lastModified)
+        || (QString::fromUtf8(path, header.pathSize) != fingerprint.path))
+        return false;
+
+    // modification time alone isn't reliable (e.g. files extracted from archives)
+    // so the contents are compared too, but only if everything else matches
+    fingerprint.hash = sourceHash();
+    if ((fingerprint.hash.size() != sizeof(header.sourceHash))
+        || (std::memcmp(header.sourceHash, fingerprint.hash.constData(), sizeof(header.sourceHash)) != 0))
+        return false;
+
+    lt::ip_filter filter;
+    for (quint32 i = 0; i < header.rangeCountV4; ++i) {
+        quint32 range[2];
+        std::memcpy(range, (rangesV4 + (i * sizeof(range))), sizeof(range));
+        if (range[0] > range[1])
+            return false;
+
+        quint32 prevLast = 0;
+        if (i > 0) {
+            std::memcpy(&prevLast, (rangesV4 + (i * sizeof(range)) - sizeof(quint32)), sizeof(quint32));
+            if (range[0] <= prevLast)
+                return false;
+        }
+
+        filter.add_rule(lt::address_v4(range[0]), lt::address_v4(range[1]), lt::ip_filter::blocked);
+
+        if (m_abort) return false;
+    }
+
+    for (quint32 i = 0; i < header.rangeCountV6; ++i) {
+        const char *range = rangesV6 + (i * 2 * sizeof(IPv6Bytes));
+        if ((std::memcmp(range, (range + sizeof(IPv6Bytes)), sizeof(IPv6Bytes)) > 0)
+            || ((i > 0) && (std::memcmp((range - sizeof(IPv6Bytes)), range, sizeof(IPv6Bytes)) >= 0)))
+            return false;
+
+        IPv6Bytes first;
+        IPv6Bytes last;
+        std::memcpy(first.data(), range, sizeof(IPv6Bytes));
+        std::memcpy(last.data(), (range + sizeof(IPv6Bytes)), sizeof(IPv6Bytes));
+        filter.add_rule(lt::address_v6(first), lt::address_v6(last), lt::ip_filter::blocked);
+
+        if (m_abort) return false;
+    }
+
+    m_filter = filter;
+    ruleCount = header.ruleCount;
+    return true;
+}
+
+void FilterParserThread::saveFilterCache(const SourceFingerprint &fingerprint, const int ruleCount) const
+{
+    if (fingerprint.hash.size() != sizeof(FilterCacheHeader::sourceHash))
+        return;
+
+#if (LIBTORRENT_VERSION_NUM < 10200)
+    const auto ranges = m_filter.export_filter();
+    const auto &rangesV4 = boost::get<0>(ranges);
+    const auto &rangesV6 = boost::get<1>(ranges);
+#else
+    const auto ranges = m_filter.export_filter();
+    const auto &rangesV4 = std::get<0>(ranges);
+    const auto &rangesV6 = std::get<1>(ranges);
+#endif
+
+    QByteArray data;
+    const QByteArray path = fingerprint.path.toUtf8();
+
+    FilterCacheHeader header;
+    std::memcpy(header.magic, FILTER_CACHE_MAGIC, sizeof(header.magic));
+    header.version = FILTER_CACHE_VERSION;
+    header.byteOrderMark = FILTER_CACHE_BYTE_ORDER_MARK;
+    header.sourceSize = fingerprint.size;
+    header.sourceLastModified = fingerprint.lastModified;
+    std::memcpy(header.sourceHash, fingerprint.hash.constData(), sizeof(header.sourceHash));
+    header.ruleCount = ruleCount;
+    header.pathSize = static_cast<quint32>(path.size());
+    header.rangeCountV4 = 0;
+    header.rangeCountV6 = 0;
+
+    // exported table covers the whole address space, store blocked ranges only
+    data.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const auto &range : rangesV4) {
+        if ((range.flags & lt::ip_filter::blocked) == 0)
+            continue;
+
+        const quint32 bounds[2] = {
+            static_cast<quint32>(range.first.to_ulong()),
+            static_cast<quint32>(range.last.to_ulong())
+        };
+        data.append(reinterpret_cast<const char *>(bounds), sizeof(bounds));
+        ++header.rangeCountV4;
+    }
+    for (const auto &range : rangesV6) {
+        if ((range.flags & lt::ip_filter::blocked) == 0)
+            continue;
+
+        const IPv6Bytes first = range.first.to_bytes();
+        const IPv6Bytes last = range.last.to_bytes();
+        data.append(reinterpret_cast<const char *>(first.data()), sizeof(IPv6Bytes));
+        data.append(reinterpret_cast<const char *>(last.data()), sizeof(IPv6Bytes));
+        ++header.rangeCountV6;
+    }
+    data.append(path);
+    std::memcpy(data.data(), &header, sizeof(header));
+
+    QSaveFile file {QDir(specialFolderLocation(SpecialFolder::Cache)).absoluteFilePath(FILTER_CACHE_FILENAME)};
+    if (!file.open(QIODevice::WriteOnly) || (file.write(data) != data.size()) || !file.commit())
+        qDebug("Couldn't save IP filter cache");
+}
+
 // Process ip filter file
 // Supported formats:
 //  * eMule IP list (DAT): http://wiki.phoenixlabs.org/wiki/DAT_Format
@@ -563,9 +805,16 @@ void FilterParserThread::run()
 {
     qDebug("Processing filter file");
     int ruleCount = 0;
-    if (m_filePath.endsWith(".p2p", Qt::CaseInsensitive)) {
+
+    // Use the previously parsed filter if the file didn't change
+    SourceFingerprint fingerprint = sourceFingerprint();
+    const bool isCached = loadFilterCache(fingerprint, ruleCount);
+    if (isCached) {
+        qDebug("IP Filter thread: loaded cached filter");
+    }
+    else if (m_filePath.endsWith(".p2p", Qt::CaseInsensitive)) {
         // PeerGuardian p2p file
-        ruleCount = parseP2PFilterFile();
+        ruleCount = parseTextFilterFile(TextFilterFormat::P2P);
     }
     else if (m_filePath.endsWith(".p2b", Qt::CaseInsensitive)) {
         // PeerGuardian p2b file
@@ -573,11 +822,17 @@ void FilterParserThread::run()
     }
     else if (m_filePath.endsWith(".dat", Qt::CaseInsensitive)) {
         // eMule DAT format
-        ruleCount = parseDATFilterFile();
+        ruleCount = parseTextFilterFile(TextFilterFormat::DAT);
     }
 
     if (m_abort) return;
 
+    if (!isCached && (ruleCount > 0)) {
+        if (fingerprint.hash.isEmpty())
+            fingerprint.hash = sourceHash();
+        saveFilterCache(fingerprint, ruleCount);
+    }
+
     try {
         emit IPFilterParsed(ruleCount);
     }
@@ -587,50 +842,3 @@ void FilterParserThread::run()
 
     qDebug("IP Filter thread: finished parsing, filter applied");
 }
-
-char* FilterParserThread::findAndNullDelimiter(char delimiter, char *const start, char *const end, bool reverse)
-{
-    if (!reverse) {
-        for (char* i = start; i <= end; ++i) {
-            if (*i == delimiter) {
-                *i = '\0';
-                return i;
-            }
-        }
-    }
-    else {
-        for (char* i = end; i >= start; --i) {
-            if (*i == delimiter) {
-                *i = '\0';
-                return i;
-            }
-        }
-    }
-
-    return nullptr;
-}
-
-char* FilterParserThread::trim(char *const start, char *const end)
-{
-    if (start >= end) return start;
-    char* newStart = start;
-
-    for (char* i = start; i <= end; ++i) {
-        if (isspace(*i) != 0) {
-            *i = '\0';
-        }
-        else {
-            newStart = i;
-            break;
-        }
-    }
-
-    for (char* i = end; i >= start; --i) {
-        if (isspace(*i) != 0)
-            *i = '\0';
-        else
-            break;
-    }
-
-    return newStart;
-}
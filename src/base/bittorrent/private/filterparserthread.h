@@ -29,6 +29,8 @@
 #ifndef FILTERPARSERTHREAD_H
 #define FILTERPARSERTHREAD_H
 
+#include <atomic>
+
 #include <libtorrent/ip_filter.hpp>
 
 #include <QThread>
@@ -53,14 +55,31 @@ protected:
     void run() override;
 
 private:
-    char* findAndNullDelimiter(char delimiter, char *const start, char *const end, bool reverse = false);
-    char* trim(char *const start, char *const end);
-    int parseDATFilterFile();
-    int parseP2PFilterFile();
+    enum class TextFilterFormat
+    {
+        DAT,
+        P2P
+    };
+
+    // Identifies the contents of the filter file
+    struct SourceFingerprint
+    {
+        QString path;
+        qint64 size = 0;
+        qint64 lastModified = 0;
+        QByteArray hash;
+    };
+
+    int parseTextFilterFile(TextFilterFormat format);
     int getlineInStream(QDataStream &stream, std::string &name, char delim);
     int parseP2BFilterFile();
 
-    bool m_abort;
+    SourceFingerprint sourceFingerprint() const;
+    QByteArray sourceHash() const;
+    bool loadFilterCache(SourceFingerprint &fingerprint, int &ruleCount);
+    void saveFilterCache(const SourceFingerprint &fingerprint, int ruleCount) const;
+
+    std::atomic<bool> m_abort;
     QString m_filePath;
     lt::ip_filter m_filter;
 };
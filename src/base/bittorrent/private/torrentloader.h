@@ -0,0 +1,66 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2020  Eugene Shalygin <eugene.shalygin@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+
+#include "base/bittorrent/magneturi.h"
+#include "base/bittorrent/torrentinfo.h"
+
+struct LoadedTorrent
+{
+    int id = 0;
+    QString source;
+    BitTorrent::MagnetUri magnetUri;
+    BitTorrent::TorrentInfo torrentInfo;
+    QString error;
+};
+
+// Loads and validates torrent sources (.torrent files or magnet links)
+// outside of the main thread. Intended to live in a worker thread.
+class TorrentLoader : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(TorrentLoader)
+
+public:
+    TorrentLoader() = default;
+
+public slots:
+    void load(int id, const QString &source);
+    // `data` is the content of .torrent file downloaded from `source`
+    void loadData(int id, const QString &source, const QByteArray &data);
+
+signals:
+    void loaded(const LoadedTorrent &result);
+};
+
+Q_DECLARE_METATYPE(LoadedTorrent)
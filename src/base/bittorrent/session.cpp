@@ -96,6 +96,7 @@
 #include "private/portforwarderimpl.h"
 #include "private/resumedatasavingmanager.h"
 #include "private/statistics.h"
+#include "private/torrentloader.h"
 #include "torrenthandle.h"
 #include "tracker.h"
 #include "trackerentry.h"
@@ -106,6 +107,13 @@
 static const char PEER_ID[] = "qB";
 static const char RESUME_FOLDER[] = "BT_backup";
 static const char USER_AGENT[] = "qBittorrent/" QBT_VERSION_2;
+// Approximate number of alerts posted while adding a single torrent
+// (add_torrent, state_changed, torrent_checked, etc.)
+static const int ALERTS_PER_ADDED_TORRENT = 8;
+static const int MAX_BULK_ADD_IN_FLIGHT = 256;
+// libtorrent alert queue is practically unlimited (see alert_queue_size),
+// so bulk adds are throttled to keep the alert backlog below this budget
+static const int BULK_ADD_ALERT_BUDGET = MAX_BULK_ADD_IN_FLIGHT * ALERTS_PER_ADDED_TORRENT;
 
 using namespace BitTorrent;
 
@@ -363,6 +371,12 @@ namespace
 
 // Session
 
+struct Session::IPFilters
+{
+    lt::ip_filter base;
+    lt::ip_filter installed;
+};
+
 Session *Session::m_instance = nullptr;
 
 #define BITTORRENT_KEY(name) "BitTorrent/" name
@@ -479,7 +493,10 @@ Session::Session(QObject *parent)
     , m_seedingLimitTimer {new QTimer {this}}
     , m_resumeDataTimer {new QTimer {this}}
     , m_statistics {new Statistics {this}}
+    , m_IPFilters {new IPFilters}
+    , m_IPFilterUpdateTimer {new QTimer {this}}
     , m_ioThread {new QThread {this}}
+    , m_torrentLoaderThread {new QThread {this}}
     , m_recentErroredTorrentsTimer {new QTimer {this}}
     , m_networkManager {new QNetworkConfigurationManager {this}}
 {
@@ -496,6 +513,10 @@ Session::Session(QObject *parent)
     m_seedingLimitTimer->setInterval(10000);
     connect(m_seedingLimitTimer, &QTimer::timeout, this, &Session::processShareLimits);
 
+    m_IPFilterUpdateTimer->setSingleShot(true);
+    m_IPFilterUpdateTimer->setInterval(500);
+    connect(m_IPFilterUpdateTimer, &QTimer::timeout, this, &Session::applyIPFilter);
+
     initializeNativeSession();
     configureComponents();
 
@@ -535,6 +556,12 @@ Session::Session(QObject *parent)
     connect(m_ioThread, &QThread::finished, m_resumeDataSavingManager, &QObject::deleteLater);
     m_ioThread->start();
 
+    m_torrentLoader = new TorrentLoader;
+    m_torrentLoader->moveToThread(m_torrentLoaderThread);
+    connect(m_torrentLoaderThread, &QThread::finished, m_torrentLoader, &QObject::deleteLater);
+    connect(m_torrentLoader, &TorrentLoader::loaded, this, &Session::handleTorrentLoaded);
+    m_torrentLoaderThread->start();
+
     // Regular saving of fastresume data
     connect(m_resumeDataTimer, &QTimer::timeout, this, [this]() { generateResumeData(); });
     const int saveInterval = static_cast<int>(saveResumeDataInterval());
@@ -940,6 +967,16 @@ void Session::setTrackerEnabled(const bool enabled)
     enableTracker(enabled);
 }
 
+int Session::trackerTorrentsCount() const
+{
+    return (m_tracker ? m_tracker->torrentsCount() : 0);
+}
+
+int Session::trackerPeersCount() const
+{
+    return (m_tracker ? m_tracker->peersCount() : 0);
+}
+
 qreal Session::globalMaxRatio() const
 {
     return m_globalMaxRatio;
@@ -990,6 +1027,10 @@ Session::~Session()
 
     qDebug("Deleting the session");
     delete m_nativeSession;
+    delete m_IPFilters;
+
+    m_torrentLoaderThread->quit();
+    m_torrentLoaderThread->wait();
 
     m_ioThread->quit();
     m_ioThread->wait();
@@ -1152,6 +1193,20 @@ void Session::processBannedIPs(lt::ip_filter &filter)
     }
 }
 
+// Rebuilds the filter from the base one and installs it immediately
+void Session::updateIPFilter()
+{
+    m_IPFilters->installed = m_IPFilters->base;
+    processBannedIPs(m_IPFilters->installed);
+    applyIPFilter();
+}
+
+void Session::applyIPFilter()
+{
+    m_IPFilterUpdateTimer->stop();
+    m_nativeSession->set_ip_filter(m_IPFilters->installed);
+}
+
 void Session::adjustLimits(lt::settings_pack &settingsPack)
 {
     // Internally increase the queue limits to ensure that the magnet is started
@@ -1712,13 +1767,12 @@ void Session::banIP(const QString &ip)
 {
     QStringList bannedIPs = m_bannedIPs;
     if (!bannedIPs.contains(ip)) {
-        lt::ip_filter filter = m_nativeSession->get_ip_filter();
         lt::error_code ec;
         const lt::address addr = lt::address::from_string(ip.toLatin1().constData(), ec);
         Q_ASSERT(!ec);
         if (ec) return;
-        filter.add_rule(addr, addr, lt::ip_filter::blocked);
-        m_nativeSession->set_ip_filter(filter);
+        m_IPFilters->installed.add_rule(addr, addr, lt::ip_filter::blocked);
+        m_IPFilterUpdateTimer->start();
 
         bannedIPs << ip;
         bannedIPs.sort();
@@ -1945,6 +1999,157 @@ bool Session::addTorrent(const TorrentInfo &torrentInfo, const AddTorrentParams
     return addTorrent_impl(CreateTorrentParams(params), MagnetUri(), torrentInfo);
 }
 
+struct Session::BulkAddItem
+{
+    QString source;
+    CreateTorrentParams params;
+    MagnetUri magnetUri;
+    TorrentInfo torrentInfo;
+    // whether the source is a local .torrent file
+    bool isFile = false;
+};
+
+void Session::addTorrents(const QStringList &sources, const AddTorrentParams &params)
+{
+    const CreateTorrentParams createTorrentParams {params};
+
+    for (const QString &source : sources) {
+        const int id = ++m_lastBulkAddID;
+        BulkAddItem &item = m_bulkAddItems[id];
+        item.source = source;
+        item.params = createTorrentParams;
+
+        if (Net::DownloadManager::hasSupportedScheme(source)) {
+            LogMsg(tr("Downloading '%1', please wait...", "e.g: Downloading 'xxx.torrent', please wait...").arg(source));
+            Net::DownloadManager::instance()->download(Net::DownloadRequest(source).limit(MAX_TORRENT_SIZE)
+                , this, [this, id](const Net::DownloadResult &result) { handleBulkAddDownloadFinished(id, result); });
+            continue;
+        }
+
+        item.isFile = !MagnetUri(source).isValid();
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+        QMetaObject::invokeMethod(m_torrentLoader, [loader = m_torrentLoader, id, source]() { loader->load(id, source); }
+                                  , Qt::QueuedConnection);
+#else
+        QMetaObject::invokeMethod(m_torrentLoader, "load", Qt::QueuedConnection
+                                  , Q_ARG(int, id), Q_ARG(QString, source));
+#endif
+    }
+}
+
+void Session::addTorrents(const QVector<TorrentInfo> &torrents, const AddTorrentParams &params)
+{
+    const CreateTorrentParams createTorrentParams {params};
+
+    for (const TorrentInfo &torrentInfo : torrents) {
+        if (!torrentInfo.isValid()) continue;
+
+        const int id = ++m_lastBulkAddID;
+        BulkAddItem &item = m_bulkAddItems[id];
+        item.source = torrentInfo.name();
+        item.params = createTorrentParams;
+        item.torrentInfo = torrentInfo;
+        m_bulkAddQueue.enqueue(id);
+    }
+
+    processBulkAddQueue();
+}
+
+void Session::handleBulkAddDownloadFinished(const int id, const Net::DownloadResult &result)
+{
+    if (!m_bulkAddItems.contains(id)) return;
+
+    switch (result.status) {
+    case Net::DownloadStatus::Success:
+        emit downloadFromUrlFinished(result.url);
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+        QMetaObject::invokeMethod(m_torrentLoader, [loader = m_torrentLoader, id, source = result.url, data = result.data]()
+        {
+            loader->loadData(id, source, data);
+        }, Qt::QueuedConnection);
+#else
+        QMetaObject::invokeMethod(m_torrentLoader, "loadData", Qt::QueuedConnection
+                                  , Q_ARG(int, id), Q_ARG(QString, result.url), Q_ARG(QByteArray, result.data));
+#endif
+        break;
+    case Net::DownloadStatus::RedirectedToMagnet: {
+            LoadedTorrent loadedTorrent;
+            loadedTorrent.id = id;
+            loadedTorrent.source = result.url;
+            loadedTorrent.magnetUri = MagnetUri(result.magnet);
+            handleTorrentLoaded(loadedTorrent);
+        }
+        break;
+    default:
+        m_bulkAddItems.remove(id);
+        emit downloadFromUrlFailed(result.url, result.errorString);
+        emit bulkAddTorrentLoadFailed(result.url, result.errorString);
+    }
+}
+
+void Session::handleTorrentLoaded(const LoadedTorrent &result)
+{
+    const auto itemIter = m_bulkAddItems.find(result.id);
+    if (itemIter == m_bulkAddItems.end()) return;
+
+    if (!result.error.isEmpty()) {
+        // the file can still be incomplete, so leave it in place
+        const QString source = itemIter->source;
+        m_bulkAddItems.erase(itemIter);
+
+        LogMsg(tr("Couldn't add torrent '%1'. Reason: %2").arg(source, result.error), Log::WARNING);
+        emit bulkAddTorrentLoadFailed(source, result.error);
+        return;
+    }
+
+    itemIter->magnetUri = result.magnetUri;
+    itemIter->torrentInfo = result.torrentInfo;
+    m_bulkAddQueue.enqueue(result.id);
+    processBulkAddQueue();
+}
+
+int Session::bulkAddCapacity() const
+{
+    // Alerts which were waiting to be popped by the latest readAlerts() show
+    // how congested the queue is. At least one torrent is always allowed in
+    // flight, so the queue keeps being processed on its add_torrent_alert.
+    const int alertHeadroom = std::max(0, (BULK_ADD_ALERT_BUDGET - m_pendingAlertsCount));
+    return std::max(1, std::min(MAX_BULK_ADD_IN_FLIGHT, (alertHeadroom / ALERTS_PER_ADDED_TORRENT)));
+}
+
+void Session::processBulkAddQueue()
+{
+    if (m_bulkAddQueue.isEmpty()) return;
+
+    // Torrents being added by other means consume the alert queue headroom too
+    const int capacity = bulkAddCapacity();
+    while (!m_bulkAddQueue.isEmpty() && (m_addingTorrents.size() < capacity)) {
+        const BulkAddItem item = m_bulkAddItems.take(m_bulkAddQueue.dequeue());
+        const bool fromMagnetUri = item.magnetUri.isValid();
+        const InfoHash hash = fromMagnetUri ? item.magnetUri.hash() : item.torrentInfo.hash();
+
+        TorrentFileGuard guard {item.isFile ? item.source : QString()};
+        if (!addTorrent_impl(item.params, item.magnetUri, item.torrentInfo)) {
+            const QString reason = m_torrents.contains(hash)
+                ? tr("The torrent is already in the session")
+                : tr("The torrent is already being added");
+            emit bulkAddTorrentFailed(item.source, reason);
+            continue;
+        }
+
+        guard.markAsAddedToSession();
+        if (m_addingTorrents.contains(hash)) {
+            // wait for add_torrent_alert
+            m_bulkAddingTorrents.insert(hash, item.source);
+        }
+        else {
+            // a duplicate was merged into existing torrent or preloaded one was reused
+            emit bulkAddTorrentFinished(item.source, m_torrents.value(hash));
+        }
+    }
+}
+
 // Add a torrent to the BitTorrent session
 bool Session::addTorrent_impl(CreateTorrentParams params, const MagnetUri &magnetUri,
                               TorrentInfo torrentInfo, const QByteArray &fastresumeData)
@@ -3019,12 +3224,34 @@ void Session::setBannedIPs(const QStringList &newList)
     // Again ensure that the new list is different from the stored one.
     if (filteredList == m_bannedIPs)
         return; // do nothing
+
+    // apply the difference on top of the installed filter,
+    // unbanned IPs get the access defined by 3rd party ban file
+    const QSet<QString> oldSet = List::toSet(m_bannedIPs.value());
+    const QSet<QString> newSet = List::toSet(filteredList);
+    for (const QString &ip : oldSet) {
+        if (newSet.contains(ip))
+            continue;
+
+        lt::error_code ec;
+        const lt::address addr = lt::address::from_string(ip.toLatin1().constData(), ec);
+        if (!ec)
+            m_IPFilters->installed.add_rule(addr, addr, m_IPFilters->base.access(addr));
+    }
+    for (const QString &ip : newSet) {
+        if (oldSet.contains(ip))
+            continue;
+
+        lt::error_code ec;
+        const lt::address addr = lt::address::from_string(ip.toLatin1().constData(), ec);
+        Q_ASSERT(!ec);
+        if (!ec)
+            m_IPFilters->installed.add_rule(addr, addr, lt::ip_filter::blocked);
+    }
+
     // store to session settings
-    // also here we have to recreate filter list including 3rd party ban file
-    // and install it again into m_session
     m_bannedIPs = filteredList;
-    m_IPFilteringConfigured = false;
-    configureDeferred();
+    m_IPFilterUpdateTimer->start();
 }
 
 QStringList Session::bannedIPs() const
@@ -3976,9 +4203,8 @@ void Session::disableIPFilter()
     // Add the banned IPs after the IPFilter disabling
     // which creates an empty filter and overrides all previously
     // applied bans.
-    lt::ip_filter filter;
-    processBannedIPs(filter);
-    m_nativeSession->set_ip_filter(filter);
+    m_IPFilters->base = lt::ip_filter();
+    updateIPFilter();
 }
 
 void Session::recursiveTorrentDownload(const InfoHash &hash)
@@ -4155,9 +4381,8 @@ void Session::refresh()
 void Session::handleIPFilterParsed(const int ruleCount)
 {
     if (m_filterParser) {
-        lt::ip_filter filter = m_filterParser->IPfilter();
-        processBannedIPs(filter);
-        m_nativeSession->set_ip_filter(filter);
+        m_IPFilters->base = m_filterParser->IPfilter();
+        updateIPFilter();
     }
     LogMsg(tr("Successfully parsed the provided IP filter: %1 rules were applied.", "%1 is a number").arg(ruleCount));
     emit IPFilterParsed(false, ruleCount);
@@ -4165,9 +4390,8 @@ void Session::handleIPFilterParsed(const int ruleCount)
 
 void Session::handleIPFilterError()
 {
-    lt::ip_filter filter;
-    processBannedIPs(filter);
-    m_nativeSession->set_ip_filter(filter);
+    m_IPFilters->base = lt::ip_filter();
+    updateIPFilter();
 
     LogMsg(tr("Error: Failed to parse the provided IP filter."), Log::CRITICAL);
     emit IPFilterParsed(true, 0);
@@ -4197,6 +4421,7 @@ void Session::setCreateTorrentSubfolder(const bool value)
 void Session::readAlerts()
 {
     const std::vector<lt::alert *> alerts = getPendingAlerts();
+    m_pendingAlertsCount = static_cast<int>(alerts.size());
     for (const lt::alert *a : alerts)
         handleAlert(a);
 }
@@ -4355,13 +4580,25 @@ void Session::handleAddTorrentAlert(const lt::add_torrent_alert *p)
 {
     if (p->error) {
         qDebug("/!\\ Error: Failed to add torrent!");
+        const InfoHash hash = p->params.ti ? p->params.ti->info_hash() : p->params.info_hash;
+        m_addingTorrents.remove(hash);
+
         QString msg = QString::fromStdString(p->message());
         LogMsg(tr("Couldn't add torrent. Reason: %1").arg(msg), Log::WARNING);
         emit addTorrentFailed(msg);
+
+        if (m_bulkAddingTorrents.contains(hash))
+            emit bulkAddTorrentFailed(m_bulkAddingTorrents.take(hash), msg);
     }
     else {
         createTorrentHandle(p->handle);
+
+        const InfoHash hash = p->handle.info_hash();
+        if (m_bulkAddingTorrents.contains(hash))
+            emit bulkAddTorrentFinished(m_bulkAddingTorrents.take(hash), m_torrents.value(hash));
     }
+
+    processBulkAddQueue();
 }
 
 void Session::handleTorrentRemovedAlert(const lt::torrent_removed_alert *p)
@@ -36,6 +36,7 @@
 
 #include <QHash>
 #include <QPointer>
+#include <QQueue>
 #include <QSet>
 #include <QVector>
 
@@ -59,6 +60,8 @@ class BandwidthScheduler;
 class FilterParserThread;
 class ResumeDataSavingManager;
 class Statistics;
+class TorrentLoader;
+struct LoadedTorrent;
 
 // These values should remain unchanged when adding new items
 // so as not to break the existing user settings.
@@ -268,6 +271,8 @@ namespace BitTorrent
         void setCreateTorrentSubfolder(bool value);
         bool isTrackerEnabled() const;
         void setTrackerEnabled(bool enabled);
+        int trackerTorrentsCount() const;
+        int trackerPeersCount() const;
         bool isAppendExtensionEnabled() const;
         void setAppendExtensionEnabled(bool enabled);
         uint refreshInterval() const;
@@ -431,6 +436,14 @@ namespace BitTorrent
         bool isKnownTorrent(const InfoHash &hash) const;
         bool addTorrent(const QString &source, const AddTorrentParams &params = AddTorrentParams());
         bool addTorrent(const TorrentInfo &torrentInfo, const AddTorrentParams &params = AddTorrentParams());
+        // Adds many torrents without blocking the caller. Sources are downloaded
+        // (URLs) and loaded in the background and passed to libtorrent in portions
+        // limited by the alert queue headroom. Result of each source is reported by
+        // bulkAddTorrentFinished()/bulkAddTorrentFailed() signals, or by
+        // bulkAddTorrentLoadFailed() if the source couldn't be read at all.
+        void addTorrents(const QStringList &sources, const AddTorrentParams &params = AddTorrentParams());
+        // Same for already loaded torrents, their names are reported as sources
+        void addTorrents(const QVector<TorrentInfo> &torrents, const AddTorrentParams &params = AddTorrentParams());
         bool deleteTorrent(const InfoHash &hash, DeleteOption deleteOption = Torrent);
         bool loadMetadata(const MagnetUri &magnetUri);
         bool cancelLoadMetadata(const InfoHash &hash);
@@ -469,6 +482,9 @@ namespace BitTorrent
     signals:
         void addTorrentFailed(const QString &error);
         void allTorrentsFinished();
+        void bulkAddTorrentFailed(const QString &source, const QString &reason);
+        void bulkAddTorrentFinished(const QString &source, BitTorrent::TorrentHandle *const torrent);
+        void bulkAddTorrentLoadFailed(const QString &source, const QString &reason);
         void categoryAdded(const QString &categoryName);
         void categoryRemoved(const QString &categoryName);
         void downloadFromUrlFailed(const QString &url, const QString &reason);
@@ -513,6 +529,8 @@ namespace BitTorrent
         void handleIPFilterParsed(int ruleCount);
         void handleIPFilterError();
         void handleDownloadFinished(const Net::DownloadResult &result);
+        void handleTorrentLoaded(const LoadedTorrent &result);
+        void handleBulkAddDownloadFinished(int id, const Net::DownloadResult &result);
 
         // Session reconfiguration triggers
         void networkOnlineStateChanged(bool online);
@@ -526,6 +544,9 @@ namespace BitTorrent
             DeleteOption deleteOption;
         };
 
+        struct BulkAddItem;
+        struct IPFilters;
+
         explicit Session(QObject *parent = nullptr);
         ~Session();
 
@@ -547,6 +568,8 @@ namespace BitTorrent
         void adjustLimits();
         void applyBandwidthLimits();
         void processBannedIPs(lt::ip_filter &filter);
+        void applyIPFilter();
+        void updateIPFilter();
         QStringList getListeningIPs() const;
         void configureListeningInterface();
         void enableTracker(bool enable);
@@ -562,6 +585,8 @@ namespace BitTorrent
                              TorrentInfo torrentInfo = TorrentInfo(),
                              const QByteArray &fastresumeData = {});
         bool findIncompleteFiles(TorrentInfo &torrentInfo, QString &savePath) const;
+        void processBulkAddQueue();
+        int bulkAddCapacity() const;
 
         void updateSeedingLimitTimer();
         void exportTorrentFile(TorrentHandle *const torrent, TorrentExportFolder folder = TorrentExportFolder::Regular);
@@ -709,12 +734,26 @@ namespace BitTorrent
         Statistics *m_statistics = nullptr;
         // IP filtering
         QPointer<FilterParserThread> m_filterParser;
+        // Installed filter is the parsed ban list file (base) with manually banned IPs on top.
+        // Manual bans are applied to the installed filter directly and it is passed to
+        // libtorrent after a short delay, so bulk (un)bans don't copy it over and over.
+        IPFilters *m_IPFilters = nullptr;
+        QTimer *m_IPFilterUpdateTimer = nullptr;
         QPointer<BandwidthScheduler> m_bwScheduler;
         // Tracker
         QPointer<Tracker> m_tracker;
         // fastresume data writing thread
         QThread *m_ioThread = nullptr;
         ResumeDataSavingManager *m_resumeDataSavingManager = nullptr;
+        // bulk torrent addition
+        QThread *m_torrentLoaderThread = nullptr;
+        TorrentLoader *m_torrentLoader = nullptr;
+        int m_lastBulkAddID = 0;
+        QHash<int, BulkAddItem> m_bulkAddItems;
+        QQueue<int> m_bulkAddQueue;
+        QHash<InfoHash, QString> m_bulkAddingTorrents;
+        // Number of alerts popped by the latest readAlerts()
+        int m_pendingAlertsCount = 0;
 
         QHash<InfoHash, TorrentInfo> m_loadedMetadata;
         QHash<InfoHash, TorrentHandle *> m_torrents;
@@ -0,0 +1,323 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2020  Eugene Shalygin <eugene.shalygin@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "torrentcreationmanager.h"
+
+#include <algorithm>
+
+#include <QDir>
+#include <QStorageInfo>
+
+#include "base/global.h"
+#include "base/logger.h"
+#include "base/profile.h"
+#include "base/settingsstorage.h"
+#include "base/utils/fs.h"
+#include "session.h"
+#include "torrentinfo.h"
+
+namespace
+{
+    const QString SettingsKey_MaxActiveTasks(QStringLiteral("BitTorrent/TorrentCreator/MaxActiveTasks"));
+    const QString SettingsKey_MaxActiveTasksPerDisk(QStringLiteral("BitTorrent/TorrentCreator/MaxActiveTasksPerDisk"));
+
+    QString diskIDOfPath(const QString &path)
+    {
+        const QStorageInfo storageInfo {path};
+        if (!storageInfo.isValid())
+            return path;
+
+        return QString::fromLocal8Bit(storageInfo.device());
+    }
+
+    QString generatedSavePathRoot()
+    {
+        return (specialFolderLocation(SpecialFolder::Data) + QLatin1String("/torrentcreator"));
+    }
+
+    QString generatedSavePath(const int id)
+    {
+        return (generatedSavePathRoot() + '/' + QString::number(id) + C_TORRENT_FILE_EXTENSION);
+    }
+}
+
+using namespace BitTorrent;
+
+TorrentCreationManager *TorrentCreationManager::m_instance = nullptr;
+
+TorrentCreationManager::TorrentCreationManager()
+    : m_maxActiveTasks(SettingsStorage::instance()->loadValue(SettingsKey_MaxActiveTasks, 2).toInt())
+    , m_maxActiveTasksPerDisk(SettingsStorage::instance()->loadValue(SettingsKey_MaxActiveTasksPerDisk, 1).toInt())
+{
+    // Tasks aren't kept between the sessions, so the torrent files
+    // saved to the profile directory are left from the previous ones
+    Utils::Fs::removeDirRecursive(generatedSavePathRoot());
+}
+
+void TorrentCreationManager::initInstance()
+{
+    if (!m_instance)
+        m_instance = new TorrentCreationManager;
+}
+
+void TorrentCreationManager::freeInstance()
+{
+    delete m_instance;
+    m_instance = nullptr;
+}
+
+TorrentCreationManager *TorrentCreationManager::instance()
+{
+    return m_instance;
+}
+
+int TorrentCreationManager::addTask(const TorrentCreatorParams &params, const bool isSeedingEnabled)
+{
+    const int id = ++m_lastTaskID;
+
+    TaskData taskData;
+    taskData.task = {id, params, isSeedingEnabled, TorrentCreationTask::Status::Queued, 0, 0, {}
+                     , QDateTime::currentDateTime(), {}, {}};
+    taskData.diskID = diskIDOfPath(params.inputPath);
+    taskData.isSavePathGenerated = params.savePath.isEmpty();
+    if (taskData.isSavePathGenerated)
+        taskData.task.params.savePath = generatedSavePath(id);
+
+    m_tasks.insert(id, taskData);
+    m_queue.append(id);
+    processQueue();
+
+    return id;
+}
+
+bool TorrentCreationManager::cancelTask(const int id)
+{
+    const auto iter = m_tasks.find(id);
+    if (iter == m_tasks.end())
+        return false;
+
+    TaskData &taskData = iter.value();
+    switch (taskData.task.status) {
+    case TorrentCreationTask::Status::Queued:
+        m_queue.removeOne(id);
+        break;
+    case TorrentCreationTask::Status::Running:
+        // thread is still considered active until it's really finished
+        if (taskData.thread)
+            taskData.thread->requestInterruption();
+        break;
+    default:
+        return false;
+    }
+
+    taskData.task.status = TorrentCreationTask::Status::Cancelled;
+    taskData.task.timeFinished = QDateTime::currentDateTime();
+    return true;
+}
+
+bool TorrentCreationManager::deleteTask(const int id)
+{
+    if (!m_tasks.contains(id))
+        return false;
+
+    cancelTask(id);
+
+    // thread of the running task is deleted once it's finished
+    const TaskData taskData = m_tasks.take(id);
+    if (taskData.isSavePathGenerated) {
+        // the running thread can still write the file, so it's removed after the thread is finished
+        if (taskData.thread && m_activeThreads.contains(taskData.thread))
+            m_deletedTaskFiles.insert(taskData.thread, taskData.task.params.savePath);
+        else
+            Utils::Fs::forceRemove(taskData.task.params.savePath);
+    }
+
+    return true;
+}
+
+QVector<TorrentCreationTask> TorrentCreationManager::tasks() const
+{
+    QVector<TorrentCreationTask> tasks;
+    tasks.reserve(m_tasks.size());
+    for (const TaskData &taskData : m_tasks)
+        tasks.append(taskData.task);
+
+    std::sort(tasks.begin(), tasks.end(), [](const TorrentCreationTask &left, const TorrentCreationTask &right)
+    {
+        return (left.id < right.id);
+    });
+    return tasks;
+}
+
+const TorrentCreationTask *TorrentCreationManager::task(const int id) const
+{
+    const auto iter = m_tasks.constFind(id);
+    return (iter != m_tasks.cend()) ? &iter.value().task : nullptr;
+}
+
+int TorrentCreationManager::maxActiveTasks() const
+{
+    return m_maxActiveTasks;
+}
+
+void TorrentCreationManager::setMaxActiveTasks(const int max)
+{
+    if ((max <= 0) || (max == m_maxActiveTasks))
+        return;
+
+    m_maxActiveTasks = max;
+    SettingsStorage::instance()->storeValue(SettingsKey_MaxActiveTasks, max);
+    processQueue();
+}
+
+int TorrentCreationManager::maxActiveTasksPerDisk() const
+{
+    return m_maxActiveTasksPerDisk;
+}
+
+void TorrentCreationManager::setMaxActiveTasksPerDisk(const int max)
+{
+    if ((max <= 0) || (max == m_maxActiveTasksPerDisk))
+        return;
+
+    m_maxActiveTasksPerDisk = max;
+    SettingsStorage::instance()->storeValue(SettingsKey_MaxActiveTasksPerDisk, max);
+    processQueue();
+}
+
+void TorrentCreationManager::processQueue()
+{
+    QHash<QString, int> activeTasksByDisk;
+    for (const QString &diskID : asConst(m_activeThreads))
+        ++activeTasksByDisk[diskID];
+
+    // Tasks are started in the order they are added, except the ones
+    // whose disk is busy, they are skipped until it's released
+    for (int i = 0; (i < m_queue.size()) && (m_activeThreads.size() < m_maxActiveTasks);) {
+        TaskData &taskData = m_tasks[m_queue[i]];
+        if (activeTasksByDisk.value(taskData.diskID) >= m_maxActiveTasksPerDisk) {
+            ++i;
+            continue;
+        }
+
+        ++activeTasksByDisk[taskData.diskID];
+        m_queue.removeAt(i);
+        startTask(taskData);
+    }
+}
+
+void TorrentCreationManager::startTask(TaskData &taskData)
+{
+    const int id = taskData.task.id;
+    taskData.task.status = TorrentCreationTask::Status::Running;
+    taskData.task.timeStarted = QDateTime::currentDateTime();
+
+    if (taskData.isSavePathGenerated)
+        QDir().mkpath(Utils::Fs::branchPath(taskData.task.params.savePath));
+
+    auto *thread = new TorrentCreatorThread(this);
+    taskData.thread = thread;
+    m_activeThreads.insert(thread, taskData.diskID);
+
+    connect(thread, &TorrentCreatorThread::updateProgress, this, [this, id](const int progress)
+    {
+        const auto iter = m_tasks.find(id);
+        if (iter != m_tasks.end())
+            iter.value().task.progress = progress;
+    });
+    connect(thread, &TorrentCreatorThread::updateSpeed, this, [this, id](const qint64 speed)
+    {
+        const auto iter = m_tasks.find(id);
+        if (iter != m_tasks.end())
+            iter.value().task.speed = speed;
+    });
+    connect(thread, &TorrentCreatorThread::creationSuccess, this
+            , [this, id](const QString &torrentPath, const QString &savePath) { handleCreationSuccess(id, torrentPath, savePath); });
+    connect(thread, &TorrentCreatorThread::creationFailure, this
+            , [this, id](const QString &errorMessage) { handleCreationFailure(id, errorMessage); });
+    connect(thread, &QThread::finished, this, [this, thread]() { handleThreadFinished(thread); });
+
+    thread->create(taskData.task.params);
+}
+
+void TorrentCreationManager::handleCreationSuccess(const int id, const QString &torrentPath, const QString &savePath)
+{
+    const auto iter = m_tasks.find(id);
+    if ((iter == m_tasks.end()) || (iter.value().task.status != TorrentCreationTask::Status::Running))
+        return;
+
+    TorrentCreationTask &task = iter.value().task;
+    task.status = TorrentCreationTask::Status::Finished;
+    task.progress = 100;
+    task.timeFinished = QDateTime::currentDateTime();
+
+    if (task.isSeedingEnabled) {
+        const TorrentInfo info = TorrentInfo::loadFromFile(Utils::Fs::toNativePath(torrentPath));
+        if (info.isValid()) {
+            AddTorrentParams params;
+            params.savePath = savePath;
+            params.skipChecking = true;
+            params.useAutoTMM = TriStateBool::False;  // otherwise if it is on by default, it will overwrite `savePath` to the default save path
+
+            Session::instance()->addTorrent(info, params);
+        }
+        else {
+            LogMsg(tr("Created torrent \"%1\" is invalid. It won't be added to download list.")
+                .arg(Utils::Fs::toNativePath(torrentPath)), Log::WARNING);
+        }
+    }
+
+    emit taskFinished(id);
+}
+
+void TorrentCreationManager::handleCreationFailure(const int id, const QString &errorMessage)
+{
+    const auto iter = m_tasks.find(id);
+    if ((iter == m_tasks.end()) || (iter.value().task.status != TorrentCreationTask::Status::Running))
+        return;
+
+    TorrentCreationTask &task = iter.value().task;
+    task.status = TorrentCreationTask::Status::Failed;
+    task.errorMessage = errorMessage;
+    task.timeFinished = QDateTime::currentDateTime();
+
+    emit taskFailed(id, errorMessage);
+}
+
+void TorrentCreationManager::handleThreadFinished(TorrentCreatorThread *thread)
+{
+    if (!m_activeThreads.remove(thread))
+        return;
+
+    const QString deletedTaskFile = m_deletedTaskFiles.take(thread);
+    if (!deletedTaskFile.isEmpty())
+        Utils::Fs::forceRemove(deletedTaskFile);
+
+    thread->deleteLater();
+    processQueue();
+}
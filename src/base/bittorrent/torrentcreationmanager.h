@@ -0,0 +1,123 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2020  Eugene Shalygin <eugene.shalygin@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QVector>
+
+#include "torrentcreatorthread.h"
+
+namespace BitTorrent
+{
+    struct TorrentCreationTask
+    {
+        enum class Status
+        {
+            Queued,
+            Running,
+            Finished,
+            Failed,
+            Cancelled
+        };
+
+        int id;
+        TorrentCreatorParams params;
+        bool isSeedingEnabled;
+        Status status;
+        int progress;
+        qint64 speed;
+        QString errorMessage;
+        QDateTime timeAdded;
+        QDateTime timeStarted;
+        QDateTime timeFinished;
+    };
+
+    // Queue of torrent creation tasks which are run in background, several at once.
+    // Tasks reading from the same disk are run one after another, so they don't
+    // compete for it while the other disks are idle.
+    class TorrentCreationManager final : public QObject
+    {
+        Q_OBJECT
+        Q_DISABLE_COPY(TorrentCreationManager)
+
+    public:
+        static void initInstance();
+        static void freeInstance();
+        static TorrentCreationManager *instance();
+
+        // If save path isn't set, torrent file is saved to the profile directory
+        int addTask(const TorrentCreatorParams &params, bool isSeedingEnabled = false);
+        bool cancelTask(int id);
+        bool deleteTask(int id);
+        QVector<TorrentCreationTask> tasks() const;
+        const TorrentCreationTask *task(int id) const;
+
+        int maxActiveTasks() const;
+        void setMaxActiveTasks(int max);
+        int maxActiveTasksPerDisk() const;
+        void setMaxActiveTasksPerDisk(int max);
+
+    signals:
+        void taskFinished(int id);
+        void taskFailed(int id, const QString &errorMessage);
+
+    private:
+        struct TaskData
+        {
+            TorrentCreationTask task;
+            QPointer<TorrentCreatorThread> thread;
+            QString diskID;
+            bool isSavePathGenerated;
+        };
+
+        TorrentCreationManager();
+
+        void processQueue();
+        void startTask(TaskData &taskData);
+        void handleCreationSuccess(int id, const QString &torrentPath, const QString &savePath);
+        void handleCreationFailure(int id, const QString &errorMessage);
+        void handleThreadFinished(TorrentCreatorThread *thread);
+
+        static TorrentCreationManager *m_instance;
+
+        QHash<int, TaskData> m_tasks;
+        QVector<int> m_queue;
+        // Disks the running threads read from, threads of deleted tasks included
+        QHash<TorrentCreatorThread *, QString> m_activeThreads;
+        // Generated torrent files of the deleted tasks whose threads are still running
+        QHash<TorrentCreatorThread *, QString> m_deletedTaskFiles;
+        int m_lastTaskID = 0;
+        int m_maxActiveTasks;
+        int m_maxActiveTasksPerDisk;
+    };
+}
@@ -30,24 +30,30 @@
 
 #include "config.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include <libtorrent/bencode.hpp>
 #include <libtorrent/create_torrent.hpp>
+#include <libtorrent/hasher.hpp>
 #include <libtorrent/storage.hpp>
 #include <libtorrent/torrent_info.hpp>
 #include <libtorrent/version.hpp>
 
-#include <QDirIterator>
+#include <QElapsedTimer>
 #include <QFile>
-#include <QFileInfo>
-#include <QHash>
 
+#include "base/bittorrent/private/filemanifest.h"
 #include "base/bittorrent/private/index.h"
 #include "base/global.h"
 #include "base/utils/fs.h"
-#include "base/utils/string.h"
-#include "private/ltunderlyingtype.h"
 
 namespace
 {
@@ -59,12 +65,212 @@ namespace
     using LTPieceIndex = lt::piece_index_t;
 #endif
 
-    // do not include files and folders whose
-    // name starts with a .
-    bool fileFilter(const std::string &f)
+    // Pieces are read and hashed in chunks of this size (at least one piece per chunk)
+    const int READ_AHEAD_SIZE = 16 * 1024 * 1024;  // 16 MiB
+    const int SPEED_UPDATE_INTERVAL = 1000;  // ms
+
+    void addFiles(lt::file_storage &fs, const FileManifest &manifest)
     {
-        return !Utils::Fs::fileName(QString::fromStdString(f)).startsWith('.');
+        const QStringList filePaths = manifest.filePaths();
+        const QVector<qint64> fileSizes = manifest.fileSizes();
+        for (int i = 0; i < filePaths.size(); ++i)
+            fs.add_file(filePaths[i].toStdString(), fileSizes[i]);
     }
+
+    // Size of the file differs from the one in the manifest, i.e. the file was modified in place
+    class FileChangedError : public std::runtime_error
+    {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // Hashes pieces of the torrent using a pool of threads. Each thread reads a chunk
+    // of consecutive pieces at once and hashes them, so chunks are read in parallel and
+    // can be finished out of order. Hashes are committed to the torrent in order.
+    class PieceHasher
+    {
+    public:
+        PieceHasher(lt::create_torrent &torrent, const std::string &basePath, const int threadCount)
+            : m_torrent {torrent}
+            , m_basePath {basePath}
+            , m_piecesPerChunk {std::max(1, (READ_AHEAD_SIZE / torrent.piece_length()))}
+            , m_chunkCount {(torrent.num_pieces() + m_piecesPerChunk - 1) / m_piecesPerChunk}
+            , m_threadCount {std::max(1, std::min(threadCount, m_chunkCount))}
+            , m_hashes(static_cast<std::size_t>(torrent.num_pieces()))
+            , m_isChunkHashed(static_cast<std::size_t>(m_chunkCount), false)
+        {
+        }
+
+        // Returns false if hashing was interrupted
+        template <typename InterruptionCheck, typename ProgressHandler>
+        bool run(InterruptionCheck isInterrupted, ProgressHandler reportProgress)
+        {
+            std::vector<std::thread> workers;
+            workers.reserve(m_threadCount);
+            for (int i = 0; i < m_threadCount; ++i) {
+                try {
+                    workers.emplace_back(&PieceHasher::hashChunks, this);
+                }
+                catch (const std::system_error &) {
+                    // out of threads, use the ones already started
+                    if (workers.empty())
+                        throw;
+                    break;
+                }
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+            qint64 lastSpeedUpdate = 0;
+            qint64 speed = 0;
+
+            int committedChunks = 0;
+            while (committedChunks < m_chunkCount) {
+                std::unique_lock<std::mutex> lock {m_mutex};
+                m_chunkHashed.wait_for(lock, std::chrono::milliseconds(100), [this, committedChunks]()
+                {
+                    return (m_isChunkHashed[committedChunks] || !m_error.empty());
+                });
+
+                if (!m_error.empty() || isInterrupted()) {
+                    m_isAborted = true;
+                    break;
+                }
+
+                const int firstCommittedChunk = committedChunks;
+                while ((committedChunks < m_chunkCount) && m_isChunkHashed[committedChunks])
+                    ++committedChunks;
+                lock.unlock();
+
+                const int firstPiece = firstCommittedChunk * m_piecesPerChunk;
+                const int endPiece = std::min((committedChunks * m_piecesPerChunk), m_torrent.num_pieces());
+                for (int piece = firstPiece; piece < endPiece; ++piece)
+                    m_torrent.set_hash(LTPieceIndex {piece}, m_hashes[piece]);
+
+                bool isSpeedUpdated = false;
+                const qint64 elapsed = timer.elapsed();
+                if ((elapsed - lastSpeedUpdate) >= SPEED_UPDATE_INTERVAL) {
+                    speed = (m_hashedBytes * 1000) / std::max<qint64>(elapsed, 1);
+                    lastSpeedUpdate = elapsed;
+                    isSpeedUpdated = true;
+                }
+                if ((committedChunks > firstCommittedChunk) || isSpeedUpdated)
+                    reportProgress(endPiece, speed);
+            }
+
+            for (std::thread &worker : workers)
+                worker.join();
+
+            if (!m_error.empty()) {
+                if (m_isFileChanged)
+                    throw FileChangedError(m_error);
+                throw std::runtime_error(m_error);
+            }
+
+            return !m_isAborted;
+        }
+
+    private:
+        void hashChunks()
+        {
+            const lt::file_storage &fs = m_torrent.files();
+            std::vector<char> buffer;
+            QFile file;
+            std::string filePath;
+
+            while (!m_isAborted) {
+                const int chunk = m_nextChunk++;
+                if (chunk >= m_chunkCount)
+                    break;
+
+                const int firstPiece = chunk * m_piecesPerChunk;
+                const int endPiece = std::min((firstPiece + m_piecesPerChunk), m_torrent.num_pieces());
+                int chunkSize = 0;
+                for (int piece = firstPiece; piece < endPiece; ++piece)
+                    chunkSize += m_torrent.piece_size(LTPieceIndex {piece});
+
+                // whole chunk is read at once, with one read per file
+                buffer.resize(static_cast<std::size_t>(chunkSize));
+                qint64 bufferOffset = 0;
+                for (const lt::file_slice &slice : fs.map_block(LTPieceIndex {firstPiece}, 0, chunkSize)) {
+                    char *data = buffer.data() + bufferOffset;
+                    bufferOffset += slice.size;
+
+                    if (fs.pad_file_at(slice.file_index)) {
+                        std::fill_n(data, slice.size, 0);
+                        continue;
+                    }
+
+                    const std::string slicePath = fs.file_path(slice.file_index, m_basePath);
+                    if (slicePath != filePath) {
+                        file.close();
+                        filePath = slicePath;
+                        file.setFileName(QString::fromStdString(filePath));
+                        if (!file.open(QIODevice::ReadOnly)) {
+                            setError(QString::fromLatin1("%1: %2").arg(file.fileName(), file.errorString()));
+                            return;
+                        }
+                        if (file.size() != fs.file_size(slice.file_index)) {
+                            m_isFileChanged = true;
+                            setError(QString::fromLatin1("%1: %2").arg(file.fileName()
+                                , BitTorrent::TorrentCreatorThread::tr("File size has changed")));
+                            return;
+                        }
+                    }
+
+                    if (!file.seek(slice.offset) || (file.read(data, slice.size) != slice.size)) {
+                        setError(QString::fromLatin1("%1: %2").arg(file.fileName(), file.errorString()));
+                        return;
+                    }
+                }
+
+                const char *pieceData = buffer.data();
+                for (int piece = firstPiece; piece < endPiece; ++piece) {
+                    const int pieceSize = m_torrent.piece_size(LTPieceIndex {piece});
+                    lt::hasher hasher;
+                    hasher.update(pieceData, pieceSize);
+                    m_hashes[piece] = hasher.final();
+                    pieceData += pieceSize;
+                }
+                m_hashedBytes += chunkSize;
+
+                {
+                    const std::lock_guard<std::mutex> lock {m_mutex};
+                    m_isChunkHashed[chunk] = true;
+                }
+                m_chunkHashed.notify_one();
+            }
+        }
+
+        void setError(const QString &error)
+        {
+            {
+                const std::lock_guard<std::mutex> lock {m_mutex};
+                if (m_error.empty())
+                    m_error = error.toStdString();
+            }
+            m_isAborted = true;
+            m_chunkHashed.notify_one();
+        }
+
+        lt::create_torrent &m_torrent;
+        const std::string m_basePath;
+        const int m_piecesPerChunk;
+        const int m_chunkCount;
+        const int m_threadCount;
+
+        // each piece hash is written by a single thread
+        std::vector<lt::sha1_hash> m_hashes;
+        std::atomic<int> m_nextChunk {0};
+        std::atomic<qint64> m_hashedBytes {0};
+        std::atomic<bool> m_isAborted {false};
+        std::atomic<bool> m_isFileChanged {false};
+
+        std::mutex m_mutex;
+        std::condition_variable m_chunkHashed;
+        std::vector<bool> m_isChunkHashed;
+        std::string m_error;
+    };
 }
 
 using namespace BitTorrent;
@@ -101,54 +307,45 @@ void TorrentCreatorThread::run()
         const QString parentPath = Utils::Fs::branchPath(m_params.inputPath) + '/';
 
         // Adding files to the torrent
-        lt::file_storage fs;
-        if (QFileInfo(m_params.inputPath).isFile()) {
-            lt::add_files(fs, Utils::Fs::toNativePath(m_params.inputPath).toStdString(), fileFilter);
-        }
-        else {
-            // need to sort the file names by natural sort order
-            QStringList dirs = {m_params.inputPath};
-
-            QDirIterator dirIter(m_params.inputPath, (QDir::AllDirs | QDir::NoDotAndDotDot), QDirIterator::Subdirectories);
-            while (dirIter.hasNext()) {
-                dirIter.next();
-                dirs += dirIter.filePath();
+        // Files modified in place aren't noticed by the cached manifest, their sizes
+        // are checked while hashing and the input path is rescanned if any differs
+        std::shared_ptr<const FileManifest> manifest = FileManifest::load(m_params.inputPath);
+        std::unique_ptr<lt::create_torrent> newTorrent;
+        for (bool isRescanned = false; ; isRescanned = true) {
+            lt::file_storage fs;
+            addFiles(fs, *manifest);
+
+            if (isInterruptionRequested()) return;
+
+            newTorrent = std::make_unique<lt::create_torrent>(fs, m_params.pieceSize, m_params.paddedFileSizeLimit
+                , (m_params.isAlignmentOptimized ? lt::create_torrent::optimize_alignment : LTCreateFlags {}));
+
+            // calculate the hash for all pieces
+            const int threadCount = (m_params.hashingThreads > 0) ? m_params.hashingThreads : QThread::idealThreadCount();
+            PieceHasher hasher {*newTorrent, Utils::Fs::toNativePath(parentPath).toStdString(), threadCount};
+            try {
+                const bool isHashed = hasher.run([this]() { return isInterruptionRequested(); }
+                    , [this, &newTorrent](const int hashedPieces, const qint64 speed)
+                {
+                    sendProgressSignal(hashedPieces, newTorrent->num_pieces());
+                    emit updateSpeed(speed);
+                });
+                if (!isHashed) return;
+                break;
             }
-            std::sort(dirs.begin(), dirs.end(), Utils::String::naturalLessThan<Qt::CaseInsensitive>);
-
-            QStringList fileNames;
-            QHash<QString, qint64> fileSizeMap;
-
-            for (const auto &dir : asConst(dirs)) {
-                QStringList tmpNames;  // natural sort files within each dir
-
-                QDirIterator fileIter(dir, QDir::Files);
-                while (fileIter.hasNext()) {
-                    fileIter.next();
-
-                    const QString relFilePath = fileIter.filePath().mid(parentPath.length());
-                    tmpNames += relFilePath;
-                    fileSizeMap[relFilePath] = fileIter.fileInfo().size();
-                }
-
-                std::sort(tmpNames.begin(), tmpNames.end(), Utils::String::naturalLessThan<Qt::CaseInsensitive>);
-                fileNames += tmpNames;
+            catch (const FileChangedError &) {
+                if (isRescanned)
+                    throw;
+                manifest = FileManifest::rescan(m_params.inputPath);
+                emit updateProgress(0);
             }
-
-            for (const auto &fileName : asConst(fileNames))
-                fs.add_file(fileName.toStdString(), fileSizeMap[fileName]);
         }
 
-        if (isInterruptionRequested()) return;
-
-        lt::create_torrent newTorrent(fs, m_params.pieceSize, m_params.paddedFileSizeLimit
-            , (m_params.isAlignmentOptimized ? lt::create_torrent::optimize_alignment : LTCreateFlags {}));
-
         // Add url seeds
         for (QString seed : asConst(m_params.urlSeeds)) {
             seed = seed.trimmed();
             if (!seed.isEmpty())
-                newTorrent.add_url_seed(seed.toStdString());
+                newTorrent->add_url_seed(seed.toStdString());
         }
 
         int tier = 0;
@@ -156,27 +353,19 @@ void TorrentCreatorThread::run()
             if (tracker.isEmpty())
                 ++tier;
             else
-                newTorrent.add_tracker(tracker.trimmed().toStdString(), tier);
+                newTorrent->add_tracker(tracker.trimmed().toStdString(), tier);
         }
 
-        if (isInterruptionRequested()) return;
-
-        // calculate the hash for all pieces
-        lt::set_piece_hashes(newTorrent, Utils::Fs::toNativePath(parentPath).toStdString()
-            , [this, &newTorrent](const LTPieceIndex n)
-        {
-            sendProgressSignal(LTUnderlyingType<LTPieceIndex> {n}, newTorrent.num_pieces());
-        });
         // Set qBittorrent as creator and add user comment to
         // torrent_info structure
-        newTorrent.set_creator(creatorStr.toUtf8().constData());
-        newTorrent.set_comment(m_params.comment.toUtf8().constData());
+        newTorrent->set_creator(creatorStr.toUtf8().constData());
+        newTorrent->set_comment(m_params.comment.toUtf8().constData());
         // Is private ?
-        newTorrent.set_priv(m_params.isPrivate);
+        newTorrent->set_priv(m_params.isPrivate);
 
         if (isInterruptionRequested()) return;
 
-        lt::entry entry = newTorrent.generate();
+        lt::entry entry = newTorrent->generate();
 
         // add source field
         if (!m_params.source.isEmpty())
@@ -213,8 +402,13 @@ int TorrentCreatorThread::calculateTotalPieces(const QString &inputPath, const i
     if (inputPath.isEmpty())
         return 0;
 
+    // the same manifest is used by torrent creation later
+    const std::shared_ptr<const FileManifest> manifest = FileManifest::load(inputPath);
+    if (manifest->filePaths().isEmpty())
+        return 0;
+
     lt::file_storage fs;
-    lt::add_files(fs, Utils::Fs::toNativePath(inputPath).toStdString(), fileFilter);
+    addFiles(fs, *manifest);
 
     return lt::create_torrent(fs, pieceSize, paddedFileSizeLimit
         , (isAlignmentOptimized ? lt::create_torrent::optimize_alignment : LTCreateFlags {})).num_pieces();
@@ -46,6 +46,8 @@ namespace BitTorrent
         QString source;
         QStringList trackers;
         QStringList urlSeeds;
+        // number of threads used for hashing pieces, 0 means the number of CPU cores
+        int hashingThreads;
     };
 
     class TorrentCreatorThread : public QThread
@@ -68,6 +70,8 @@ namespace BitTorrent
         void creationFailure(const QString &msg);
         void creationSuccess(const QString &path, const QString &branchPath);
         void updateProgress(int progress);
+        // hashing speed in bytes per second
+        void updateSpeed(qint64 speed);
 
     private:
         void sendProgressSignal(int currentPieceIdx, int totalPieces);
@@ -30,10 +30,19 @@
 
 #include "tracker.h"
 
+#include <algorithm>
+#include <cstring>
+#include <map>
+
 #include <libtorrent/bencode.hpp>
 #include <libtorrent/entry.hpp>
 
+#include <QCryptographicHash>
 #include <QHostAddress>
+#include <QNetworkDatagram>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QtEndian>
 
 #include "base/exceptions.h"
 #include "base/global.h"
@@ -42,18 +51,21 @@
 #include "base/http/types.h"
 #include "base/logger.h"
 #include "base/preferences.h"
+#include "base/utils/random.h"
 
 namespace
 {
-    // static limits
-    const int MAX_TORRENTS = 10000;
-    const int MAX_PEERS_PER_TORRENT = 200;
     const int ANNOUNCE_INTERVAL = 1800;  // 30min
+    // peers missing their next announce (with some grace time) are dropped
+    const int PEER_EXPIRATION_TIME = ANNOUNCE_INTERVAL * 3 / 2;
+    const int EXPIRATION_WHEEL_SLOT_DURATION = 60;  // 1min
+    const int EXPIRATION_WHEEL_SIZE = (PEER_EXPIRATION_TIME / EXPIRATION_WHEEL_SLOT_DURATION) + 1;
 
     // constants
     const int PEER_ID_SIZE = 20;
 
     const char ANNOUNCE_REQUEST_PATH[] = "/announce";
+    const char SCRAPE_REQUEST_PATH[] = "/scrape";
 
     const char ANNOUNCE_REQUEST_COMPACT[] = "compact";
     const char ANNOUNCE_REQUEST_INFO_HASH[] = "info_hash";
@@ -83,6 +95,34 @@ namespace
     const char ANNOUNCE_RESPONSE_PEERS_PEER_ID[] = "peer id";
     const char ANNOUNCE_RESPONSE_PEERS_PORT[] = "port";
 
+    const char SCRAPE_REQUEST_INFO_HASH[] = "info_hash";
+
+    const char SCRAPE_RESPONSE_COMPLETE[] = "complete";
+    const char SCRAPE_RESPONSE_DOWNLOADED[] = "downloaded";
+    const char SCRAPE_RESPONSE_FILES[] = "files";
+    const char SCRAPE_RESPONSE_INCOMPLETE[] = "incomplete";
+
+    // limits number of torrents in a single scrape request
+    const int MAX_SCRAPE_TORRENTS = 1000;
+
+    // [BEP-15] UDP Tracker Protocol
+    const quint64 UDP_PROTOCOL_ID = 0x41727101980;
+    // connection ID stays valid until the secret is rotated twice
+    const int UDP_CONNECTION_SECRET_LIFETIME = 60 * 1000;  // 1min
+    const int UDP_REQUEST_HEADER_SIZE = 16;
+    const int UDP_ANNOUNCE_REQUEST_SIZE = 98;
+    const int UDP_MAX_SCRAPE_TORRENTS = 74;
+
+    const quint32 UDP_ACTION_CONNECT = 0;
+    const quint32 UDP_ACTION_ANNOUNCE = 1;
+    const quint32 UDP_ACTION_SCRAPE = 2;
+    const quint32 UDP_ACTION_ERROR = 3;
+
+    const quint32 UDP_EVENT_NONE = 0;
+    const quint32 UDP_EVENT_COMPLETED = 1;
+    const quint32 UDP_EVENT_STARTED = 2;
+    const quint32 UDP_EVENT_STOPPED = 3;
+
     class TrackerError : public RuntimeError
     {
     public:
@@ -117,6 +157,51 @@ namespace
             return {};
         };
     }
+
+    QHostAddress normalizedAddress(const QHostAddress &addr)
+    {
+        // dual-stack socket reports IPv4 clients as IPv4-mapped IPv6 addresses
+        bool isIPv4 = false;
+        const quint32 ipv4 = addr.toIPv4Address(&isIPv4);
+        return isIPv4 ? QHostAddress {ipv4} : addr;
+    }
+
+    void bencodeString(QByteArray &out, const QByteArray &str)
+    {
+        out.append(QByteArray::number(str.size())).append(':').append(str);
+    }
+
+    void bencodeInteger(QByteArray &out, const qint64 value)
+    {
+        out.append('i').append(QByteArray::number(value)).append('e');
+    }
+
+    quint64 randomConnectionSecret()
+    {
+        return ((static_cast<quint64>(Utils::Random::rand()) << 32) | Utils::Random::rand());
+    }
+
+    template <typename T>
+    T readBigEndian(const QByteArray &data, const int offset)
+    {
+        return qFromBigEndian<T>(data.constData() + offset);
+    }
+
+    template <typename T>
+    void appendBigEndian(QByteArray &data, const T value)
+    {
+        const T bigEndianValue = qToBigEndian(value);
+        data.append(reinterpret_cast<const char *>(&bigEndianValue), sizeof(bigEndianValue));
+    }
+
+    QByteArray udpErrorReply(const quint32 transactionID, const char *message)
+    {
+        QByteArray reply;
+        appendBigEndian(reply, UDP_ACTION_ERROR);
+        appendBigEndian(reply, transactionID);
+        reply.append(message);
+        return reply;
+    }
 }
 
 namespace BitTorrent
@@ -156,15 +241,102 @@ struct Tracker::TrackerAnnounceRequest
     int numwant = 50;
     bool compact = true;
     bool noPeerId = false;
+
+    void cachePeerAddress();
+};
+
+struct Tracker::ExpirationEntry
+{
+    InfoHash infoHash;
+    lt::entry::string_type address;
+    ushort port;
 };
 
+void Tracker::TrackerAnnounceRequest::cachePeerAddress()
+{
+    // cache `peers` field so we don't recompute when sending response
+    const QHostAddress claimedIPAddress {QString::fromLatin1(claimedAddress)};
+    peer.endpoint = toBigEndianByteArray(!claimedIPAddress.isNull() ? claimedIPAddress : socketAddress)
+        .append(static_cast<char>((peer.port >> 8) & 0xFF))
+        .append(static_cast<char>(peer.port & 0xFF))
+        .toStdString();
+
+    // cache `address` field so we don't recompute when sending response
+    peer.address = !claimedAddress.isEmpty()
+        ? claimedAddress.constData()
+        : socketAddress.toString().toLatin1().constData();
+}
+
+// Tracker::CompactPeerList
+Tracker::CompactPeerList::CompactPeerList(const int entrySize)
+    : m_entrySize(entrySize)
+{
+}
+
+int Tracker::CompactPeerList::size() const
+{
+    return m_entryOwners.size();
+}
+
+void Tracker::CompactPeerList::add(const Peer &peer)
+{
+    Q_ASSERT(peer.endpoint.size() == static_cast<std::size_t>(m_entrySize));
+
+    const QByteArray id = peer.uniqueID();
+    if (m_entryIndices.contains(id))
+        return;
+
+    m_entryIndices.insert(id, m_entryOwners.size());
+    m_entryOwners.append(id);
+    m_data.append(peer.endpoint.data(), m_entrySize);
+}
+
+void Tracker::CompactPeerList::remove(const Peer &peer)
+{
+    const auto iter = m_entryIndices.find(peer.uniqueID());
+    if (iter == m_entryIndices.end())
+        return;
+
+    const int index = iter.value();
+    const int lastIndex = m_entryOwners.size() - 1;
+    m_entryIndices.erase(iter);
+
+    if (index != lastIndex) {
+        // move the last entry into the freed slot
+        std::memcpy((m_data.data() + (index * m_entrySize))
+            , (m_data.constData() + (lastIndex * m_entrySize)), m_entrySize);
+        m_entryOwners[index] = m_entryOwners[lastIndex];
+        m_entryIndices[m_entryOwners[index]] = index;
+    }
+
+    m_entryOwners.removeLast();
+    m_data.chop(m_entrySize);
+}
+
+QByteArray Tracker::CompactPeerList::sample(const int count) const
+{
+    const int total = size();
+    if (count >= total)
+        return m_data;
+    if (count <= 0)
+        return {};
+
+    // take a window of `count` entries wrapping around the end of the list,
+    // so that different peers get different parts of the swarm
+    const int start = static_cast<int>(Utils::Random::rand(0, (total - 1)));
+    const int tailCount = std::min(count, (total - start));
+    QByteArray result = m_data.mid((start * m_entrySize), (tailCount * m_entrySize));
+    result.append(m_data.constData(), ((count - tailCount) * m_entrySize));
+    return result;
+}
+
 // Tracker::TorrentStats
-void Tracker::TorrentStats::setPeer(const Peer &peer)
+void Tracker::TorrentStats::setPeer(const Peer &peer, const int maxPeers)
 {
     // always replace existing peer
     if (!removePeer(peer)) {
-        // Too many peers, remove a random one
-        if (peers.size() >= MAX_PEERS_PER_TORRENT)
+        // Too many peers, remove random ones
+        while (!peers.isEmpty() && (peers.size() >= maxPeers))
             removePeer(*peers.begin());
     }
 
@@ -172,6 +344,11 @@ void Tracker::TorrentStats::setPeer(const Peer &peer)
     if (peer.isSeeder)
         ++seeders;
     peers.insert(peer);
+
+    if (peer.endpoint.size() == 6)  // IPv4
+        peers4.add(peer);
+    else if (peer.endpoint.size() == 18)  // IPv6
+        peers6.add(peer);
 }
 
 bool Tracker::TorrentStats::removePeer(const Peer &peer)
@@ -182,6 +359,8 @@ bool Tracker::TorrentStats::removePeer(const Peer &peer)
 
     if (iter->isSeeder)
         --seeders;
+    peers4.remove(*iter);
+    peers6.remove(*iter);
     peers.remove(*iter);
     return true;
 }
@@ -190,10 +369,109 @@ bool Tracker::TorrentStats::removePeer(const Peer &peer)
 Tracker::Tracker(QObject *parent)
     : QObject(parent)
     , m_server(new Http::Server(this, this))
+    , m_udpSocket(new QUdpSocket(this))
+    , m_connectionSecretTimer(new QTimer(this))
+    , m_connectionSecret(randomConnectionSecret())
+    , m_prevConnectionSecret(randomConnectionSecret())
+    , m_maxTorrents(Preferences::instance()->getTrackerMaxTorrents())
+    , m_maxPeersPerTorrent(Preferences::instance()->getTrackerMaxPeersPerTorrent())
+    , m_expirationTimer(new QTimer(this))
+    , m_expirationWheel(EXPIRATION_WHEEL_SIZE)
 {
+    connect(m_udpSocket, &QUdpSocket::readyRead, this, &Tracker::readPendingDatagrams);
+
+    m_connectionSecretTimer->setInterval(UDP_CONNECTION_SECRET_LIFETIME);
+    connect(m_connectionSecretTimer, &QTimer::timeout, this, &Tracker::rotateConnectionSecret);
+
+    m_clock.start();
+    m_expirationTimer->setInterval(EXPIRATION_WHEEL_SLOT_DURATION * 1000);
+    connect(m_expirationTimer, &QTimer::timeout, this, &Tracker::removeExpiredPeers);
+    m_expirationTimer->start();
 }
 
+Tracker::~Tracker() = default;
+
 bool Tracker::start()
+{
+    applyLimits();
+
+    const bool httpStarted = startHttpServer();
+    const bool udpStarted = startUdpServer();
+    return (httpStarted && udpStarted);
+}
+
+int Tracker::torrentsCount() const
+{
+    return m_torrents.size();
+}
+
+int Tracker::peersCount() const
+{
+    return m_peersCount;
+}
+
+qint64 Tracker::currentTime() const
+{
+    return (m_clock.elapsed() / 1000);
+}
+
+void Tracker::applyLimits()
+{
+    const Preferences *pref = Preferences::instance();
+    m_maxTorrents = pref->getTrackerMaxTorrents();
+    m_maxPeersPerTorrent = pref->getTrackerMaxPeersPerTorrent();
+
+    // Limits could have been lowered, remove random torrents and peers
+    while (m_torrents.size() > m_maxTorrents) {
+        const auto torrentStatsIter = m_torrents.begin();
+        m_peersCount -= torrentStatsIter->peers.size();
+        m_torrents.erase(torrentStatsIter);
+    }
+
+    // expiration entries of the removed peers are skipped by the wheel
+    for (TorrentStats &torrentStats : m_torrents) {
+        while (torrentStats.peers.size() > m_maxPeersPerTorrent) {
+            const Peer peer = *torrentStats.peers.cbegin();
+            torrentStats.removePeer(peer);
+            --m_peersCount;
+        }
+    }
+}
+
+void Tracker::removeExpiredPeers()
+{
+    m_expirationWheelPos = (m_expirationWheelPos + 1) % m_expirationWheel.size();
+
+    QVector<ExpirationEntry> entries;
+    entries.swap(m_expirationWheel[m_expirationWheelPos]);
+
+    const qint64 now = currentTime();
+    for (const ExpirationEntry &entry : asConst(entries)) {
+        const auto torrentStatsIter = m_torrents.find(entry.infoHash);
+        if (torrentStatsIter == m_torrents.end())
+            continue;
+
+        Peer key;
+        key.address = entry.address;
+        key.port = entry.port;
+        const auto peerIter = torrentStatsIter->peers.constFind(key);
+        if (peerIter == torrentStatsIter->peers.cend())
+            continue;
+
+        // peer has announced since then, it has another entry in a later slot
+        if ((now - peerIter->lastSeen) < (PEER_EXPIRATION_TIME - (2 * EXPIRATION_WHEEL_SLOT_DURATION)))
+            continue;
+
+        const Peer peer = *peerIter;
+        torrentStatsIter->removePeer(peer);
+        --m_peersCount;
+
+        if (torrentStatsIter->peers.isEmpty())
+            m_torrents.erase(torrentStatsIter);
+    }
+}
+
+bool Tracker::startHttpServer()
 {
     const QHostAddress ip = QHostAddress::Any;
     const int port = Preferences::instance()->getTrackerPort();
@@ -224,6 +502,201 @@ bool Tracker::start()
     return listenSuccess;
 }
 
+bool Tracker::startUdpServer()
+{
+    const QHostAddress ip = QHostAddress::Any;
+    const int port = Preferences::instance()->getTrackerUDPPort();
+
+    if (m_udpSocket->state() == QAbstractSocket::BoundState) {
+        if (m_udpSocket->localPort() == port) {
+            // Already listening on the right port, just return
+            return true;
+        }
+
+        m_udpSocket->close();
+    }
+
+    // UDP protocol is disabled
+    if (port == 0) {
+        m_connectionSecretTimer->stop();
+        return true;
+    }
+
+    const bool bindSuccess = m_udpSocket->bind(ip, port);
+
+    if (bindSuccess) {
+        m_connectionSecretTimer->start();
+        LogMsg(tr("Embedded Tracker: Now listening for UDP announces on IP: %1, port: %2")
+            .arg(ip.toString(), QString::number(port)), Log::INFO);
+    }
+    else {
+        LogMsg(tr("Embedded Tracker: Unable to bind UDP socket to IP: %1, port: %2. Reason: %3")
+                .arg(ip.toString(), QString::number(port), m_udpSocket->errorString())
+            , Log::WARNING);
+    }
+
+    return bindSuccess;
+}
+
+void Tracker::readPendingDatagrams()
+{
+    while (m_udpSocket->hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = m_udpSocket->receiveDatagram();
+        const QHostAddress senderAddress = normalizedAddress(datagram.senderAddress());
+        const quint16 senderPort = static_cast<quint16>(datagram.senderPort());
+
+        const QByteArray reply = processUdpRequest(datagram.data(), senderAddress, senderPort);
+        if (!reply.isEmpty())
+            m_udpSocket->writeDatagram(reply, datagram.senderAddress(), datagram.senderPort());
+    }
+}
+
+void Tracker::rotateConnectionSecret()
+{
+    m_prevConnectionSecret = m_connectionSecret;
+    m_connectionSecret = randomConnectionSecret();
+}
+
+quint64 Tracker::udpConnectionID(const quint64 secret, const QHostAddress &address, const quint16 port) const
+{
+    // connection ID is a keyed hash of client endpoint, so we don't need to keep any per-client state
+    QByteArray data = toBigEndianByteArray(address);
+    appendBigEndian(data, port);
+    appendBigEndian(data, secret);
+
+    const QByteArray digest = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+    return readBigEndian<quint64>(digest, 0);
+}
+
+QByteArray Tracker::processUdpRequest(const QByteArray &datagram, const QHostAddress &address, const quint16 port)
+{
+    // too short to even send back an error
+    if (datagram.size() < UDP_REQUEST_HEADER_SIZE)
+        return {};
+
+    const quint64 connectionID = readBigEndian<quint64>(datagram, 0);
+    const quint32 action = readBigEndian<quint32>(datagram, 8);
+    const quint32 transactionID = readBigEndian<quint32>(datagram, 12);
+
+    if (action == UDP_ACTION_CONNECT) {
+        if (connectionID != UDP_PROTOCOL_ID)
+            return {};
+
+        QByteArray reply;
+        appendBigEndian(reply, UDP_ACTION_CONNECT);
+        appendBigEndian(reply, transactionID);
+        appendBigEndian(reply, udpConnectionID(m_connectionSecret, address, port));
+        return reply;
+    }
+
+    if ((connectionID != udpConnectionID(m_connectionSecret, address, port))
+        && (connectionID != udpConnectionID(m_prevConnectionSecret, address, port))) {
+        return udpErrorReply(transactionID, "Invalid connection ID");
+    }
+
+    try {
+        switch (action) {
+        case UDP_ACTION_ANNOUNCE:
+            return processUdpAnnounceRequest(datagram, address);
+        case UDP_ACTION_SCRAPE:
+            return processUdpScrapeRequest(datagram);
+        default:
+            throw TrackerError("Invalid action");
+        }
+    }
+    catch (const TrackerError &error) {
+        return udpErrorReply(transactionID, error.what());
+    }
+}
+
+QByteArray Tracker::processUdpAnnounceRequest(const QByteArray &datagram, const QHostAddress &address)
+{
+    if (datagram.size() < UDP_ANNOUNCE_REQUEST_SIZE)
+        throw TrackerError("Malformed announce request");
+
+    const quint32 transactionID = readBigEndian<quint32>(datagram, 12);
+
+    TrackerAnnounceRequest announceReq;
+    announceReq.socketAddress = address;
+    announceReq.infoHash = InfoHash(datagram.mid(16, 20).toHex());
+    announceReq.peer.peerId = datagram.mid(36, PEER_ID_SIZE);
+    announceReq.peer.isSeeder = (readBigEndian<qint64>(datagram, 64) == 0);
+
+    const quint32 claimedIP = readBigEndian<quint32>(datagram, 84);
+    if (claimedIP != 0)
+        announceReq.claimedAddress = QHostAddress {claimedIP}.toString().toLatin1();
+
+    const qint32 numwant = readBigEndian<qint32>(datagram, 92);
+    if (numwant >= 0)
+        announceReq.numwant = numwant;
+
+    announceReq.peer.port = readBigEndian<quint16>(datagram, 96);
+    if (announceReq.peer.port == 0)
+        throw TrackerError("Invalid port");
+
+    announceReq.cachePeerAddress();
+
+    switch (readBigEndian<quint32>(datagram, 80)) {
+    case UDP_EVENT_COMPLETED:
+        announceReq.event = ANNOUNCE_REQUEST_EVENT_COMPLETED;
+        registerPeer(announceReq);
+        break;
+    case UDP_EVENT_NONE:
+    case UDP_EVENT_STARTED:
+        registerPeer(announceReq);
+        break;
+    case UDP_EVENT_STOPPED:
+        unregisterPeer(announceReq);
+        break;
+    default:
+        throw TrackerError("Invalid event");
+    }
+
+    const TorrentStats &torrentStats = m_torrents[announceReq.infoHash];
+
+    QByteArray reply;
+    appendBigEndian(reply, UDP_ACTION_ANNOUNCE);
+    appendBigEndian(reply, transactionID);
+    appendBigEndian<quint32>(reply, ANNOUNCE_INTERVAL);
+    appendBigEndian<quint32>(reply, (torrentStats.peers.size() - torrentStats.seeders));
+    appendBigEndian<quint32>(reply, torrentStats.seeders);
+
+    // peers of the same address family as the requester
+    const CompactPeerList &peerList = (address.protocol() == QAbstractSocket::IPv6Protocol)
+        ? torrentStats.peers6 : torrentStats.peers4;
+    reply.append(peerList.sample(announceReq.numwant));
+
+    if (torrentStats.peers.isEmpty())
+        m_torrents.remove(announceReq.infoHash);
+
+    return reply;
+}
+
+QByteArray Tracker::processUdpScrapeRequest(const QByteArray &datagram)
+{
+    const int hashCount = std::min(((datagram.size() - UDP_REQUEST_HEADER_SIZE) / 20), UDP_MAX_SCRAPE_TORRENTS);
+    if (hashCount <= 0)
+        throw TrackerError("Malformed scrape request");
+
+    QByteArray reply;
+    appendBigEndian(reply, UDP_ACTION_SCRAPE);
+    appendBigEndian(reply, readBigEndian<quint32>(datagram, 12));
+
+    for (int i = 0; i < hashCount; ++i) {
+        const InfoHash infoHash {datagram.mid((UDP_REQUEST_HEADER_SIZE + (i * 20)), 20).toHex()};
+        const auto torrentStatsIter = m_torrents.constFind(infoHash);
+        const bool found = (torrentStatsIter != m_torrents.cend());
+        const qint64 seeders = found ? torrentStatsIter->seeders : 0;
+        const qint64 leechers = found ? (torrentStatsIter->peers.size() - seeders) : 0;
+
+        appendBigEndian<quint32>(reply, seeders);
+        appendBigEndian<quint32>(reply, (found ? torrentStatsIter->completed : 0));
+        appendBigEndian<quint32>(reply, leechers);
+    }
+
+    return reply;
+}
+
 Http::Response Tracker::processRequest(const Http::Request &request, const Http::Environment &env)
 {
     clear();  // clear response
@@ -238,8 +711,11 @@ Http::Response Tracker::processRequest(const Http::Request &request, const Http:
         if (request.method != Http::HEADER_REQUEST_METHOD_GET)
             throw MethodNotAllowedHTTPError();
 
-        if (request.path.toLower().startsWith(ANNOUNCE_REQUEST_PATH))
+        const QString path = request.path.toLower();
+        if (path.startsWith(ANNOUNCE_REQUEST_PATH))
             processAnnounceRequest();
+        else if (path.startsWith(SCRAPE_REQUEST_PATH))
+            processScrapeRequest();
         else
             throw NotFoundHTTPError();
     }
@@ -323,19 +799,10 @@ void Tracker::processAnnounceRequest()
     // 7. compact
     announceReq.compact = (queryParams.value(ANNOUNCE_REQUEST_COMPACT) != "0");
 
-    // 8. cache `peers` field so we don't recompute when sending response
-    const QHostAddress claimedIPAddress {QString::fromLatin1(announceReq.claimedAddress)};
-    announceReq.peer.endpoint = toBigEndianByteArray(!claimedIPAddress.isNull() ? claimedIPAddress : announceReq.socketAddress)
-        .append(static_cast<char>((announceReq.peer.port >> 8) & 0xFF))
-        .append(static_cast<char>(announceReq.peer.port & 0xFF))
-        .toStdString();
-
-    // 9. cache `address` field so we don't recompute when sending response
-    announceReq.peer.address = !announceReq.claimedAddress.isEmpty()
-        ? announceReq.claimedAddress.constData()
-        : announceReq.socketAddress.toString().toLatin1().constData(),
+    // 8. cache `peers` and `address` fields so we don't recompute when sending response
+    announceReq.cachePeerAddress();
 
-    // 10. event
+    // 9. event
     announceReq.event = queryParams.value(ANNOUNCE_REQUEST_EVENT);
 
     if (announceReq.event.isEmpty()
@@ -355,15 +822,83 @@ void Tracker::processAnnounceRequest()
     }
 }
 
+void Tracker::processScrapeRequest()
+{
+    // [BEP-48] Tracker Protocol Extension: Scrape
+    const QList<QByteArray> infoHashParams = m_request.query.values(SCRAPE_REQUEST_INFO_HASH);
+    // full scrape isn't supported since it would reveal every torrent the tracker knows
+    if (infoHashParams.isEmpty())
+        throw TrackerError("Missing \"info_hash\" parameter");
+    if (infoHashParams.size() > MAX_SCRAPE_TORRENTS)
+        throw TrackerError("Too many \"info_hash\" parameters");
+
+    // dictionary keys must be sorted by raw bytes
+    std::map<QByteArray, const TorrentStats *> files;
+    for (const QByteArray &infoHashParam : infoHashParams) {
+        const InfoHash infoHash(infoHashParam.toHex());
+        if (!infoHash.isValid())
+            throw TrackerError("Invalid \"info_hash\" parameter");
+
+        const auto iter = m_torrents.constFind(infoHash);
+        files.emplace(infoHashParam, ((iter != m_torrents.cend()) ? &iter.value() : nullptr));
+    }
+
+    QByteArray reply = "d";
+    bencodeString(reply, SCRAPE_RESPONSE_FILES);
+    reply.append('d');
+    for (const auto &file : files) {
+        const TorrentStats *torrentStats = file.second;
+        const qint64 seeders = torrentStats ? torrentStats->seeders : 0;
+
+        bencodeString(reply, file.first);
+        reply.append('d');
+        bencodeString(reply, SCRAPE_RESPONSE_COMPLETE);
+        bencodeInteger(reply, seeders);
+        bencodeString(reply, SCRAPE_RESPONSE_DOWNLOADED);
+        bencodeInteger(reply, (torrentStats ? torrentStats->completed : 0));
+        bencodeString(reply, SCRAPE_RESPONSE_INCOMPLETE);
+        bencodeInteger(reply, (torrentStats ? (torrentStats->peers.size() - seeders) : 0));
+        reply.append('e');
+    }
+    reply.append("ee");
+
+    print(reply, Http::CONTENT_TYPE_TXT);
+}
+
 void Tracker::registerPeer(const TrackerAnnounceRequest &announceReq)
 {
     if (!m_torrents.contains(announceReq.infoHash)) {
         // Reached max size, remove a random torrent
-        if (m_torrents.size() >= MAX_TORRENTS)
-            m_torrents.erase(m_torrents.begin());
+        if (!m_torrents.isEmpty() && (m_torrents.size() >= m_maxTorrents)) {
+            const auto torrentStatsIter = m_torrents.begin();
+            m_peersCount -= torrentStatsIter->peers.size();
+            m_torrents.erase(torrentStatsIter);
+        }
     }
 
-    m_torrents[announceReq.infoHash].setPeer(announceReq.peer);
+    Peer peer = announceReq.peer;
+    peer.lastSeen = currentTime();
+
+    TorrentStats &torrentStats = m_torrents[announceReq.infoHash];
+    const auto oldPeerIter = torrentStats.peers.constFind(peer);
+    // peers announcing more often than the wheel ticks are already scheduled
+    const bool isScheduled = (oldPeerIter != torrentStats.peers.cend())
+        && ((peer.lastSeen - oldPeerIter->lastSeen) < EXPIRATION_WHEEL_SLOT_DURATION);
+    if (isScheduled)
+        peer.lastSeen = oldPeerIter->lastSeen;
+
+    if (announceReq.event == ANNOUNCE_REQUEST_EVENT_COMPLETED)
+        ++torrentStats.completed;
+
+    const int oldPeersCount = torrentStats.peers.size();
+    torrentStats.setPeer(peer, m_maxPeersPerTorrent);
+    m_peersCount += (torrentStats.peers.size() - oldPeersCount);
+
+    if (!isScheduled) {
+        // schedule expiration to the farthest slot of the wheel
+        const int slot = (m_expirationWheelPos + m_expirationWheel.size() - 1) % m_expirationWheel.size();
+        m_expirationWheel[slot].append({announceReq.infoHash, peer.address, peer.port});
+    }
 }
 
 void Tracker::unregisterPeer(const TrackerAnnounceRequest &announceReq)
@@ -372,7 +907,8 @@ void Tracker::unregisterPeer(const TrackerAnnounceRequest &announceReq)
     if (torrentStatsIter == m_torrents.end())
         return;
 
-    torrentStatsIter->removePeer(announceReq.peer);
+    if (torrentStatsIter->removePeer(announceReq.peer))
+        --m_peersCount;
 
     if (torrentStatsIter->peers.isEmpty())
         m_torrents.erase(torrentStatsIter);
@@ -382,6 +918,49 @@ void Tracker::prepareAnnounceResponse(const TrackerAnnounceRequest &announceReq)
 {
     const TorrentStats &torrentStats = m_torrents[announceReq.infoHash];
 
+    // peer list
+    // [BEP-7] IPv6 Tracker Extension (partial support)
+    // [BEP-23] Tracker Returns Compact Peer Lists
+    if (announceReq.compact) {
+        // Peers of the requester's address family take precedence
+        int peers4Count = 0;
+        int peers6Count = 0;
+        if (announceReq.socketAddress.protocol() == QAbstractSocket::IPv6Protocol) {
+            peers6Count = std::min(announceReq.numwant, torrentStats.peers6.size());
+            peers4Count = std::min((announceReq.numwant - peers6Count), torrentStats.peers4.size());
+        }
+        else {
+            peers4Count = std::min(announceReq.numwant, torrentStats.peers4.size());
+            peers6Count = std::min((announceReq.numwant - peers4Count), torrentStats.peers6.size());
+        }
+
+        const QByteArray peers = torrentStats.peers4.sample(peers4Count);
+        const QByteArray peers6 = torrentStats.peers6.sample(peers6Count);
+
+        // Splice the packed lists into bencoded dictionary directly,
+        // keys must be in lexicographical order
+        QByteArray reply {"d"};
+        bencodeString(reply, ANNOUNCE_RESPONSE_COMPLETE);
+        bencodeInteger(reply, torrentStats.seeders);
+        // [BEP-24] Tracker Returns External IP
+        bencodeString(reply, ANNOUNCE_RESPONSE_EXTERNAL_IP);
+        bencodeString(reply, toBigEndianByteArray(announceReq.socketAddress));
+        bencodeString(reply, ANNOUNCE_RESPONSE_INCOMPLETE);
+        bencodeInteger(reply, (torrentStats.peers.size() - torrentStats.seeders));
+        bencodeString(reply, ANNOUNCE_RESPONSE_INTERVAL);
+        bencodeInteger(reply, ANNOUNCE_INTERVAL);
+        bencodeString(reply, ANNOUNCE_RESPONSE_PEERS);  // required, even it's empty
+        bencodeString(reply, peers);
+        if (!peers6.isEmpty()) {
+            bencodeString(reply, ANNOUNCE_RESPONSE_PEERS6);
+            bencodeString(reply, peers6);
+        }
+        reply.append('e');
+
+        print(reply, Http::CONTENT_TYPE_TXT);
+        return;
+    }
+
     lt::entry::dictionary_type replyDict {
         {ANNOUNCE_RESPONSE_INTERVAL, ANNOUNCE_INTERVAL},
         {ANNOUNCE_RESPONSE_COMPLETE, torrentStats.seeders},
@@ -391,50 +970,27 @@ void Tracker::prepareAnnounceResponse(const TrackerAnnounceRequest &announceReq)
         {ANNOUNCE_RESPONSE_EXTERNAL_IP, toBigEndianByteArray(announceReq.socketAddress).toStdString()}
     };
 
-    // peer list
-    // [BEP-7] IPv6 Tracker Extension (partial support)
-    // [BEP-23] Tracker Returns Compact Peer Lists
-    if (announceReq.compact) {
-        lt::entry::list_type peerList;
-        lt::entry::list_type peer6List;
-
-        int counter = 0;
-        for (const Peer &peer : asConst(torrentStats.peers)) {
-            if (counter++ >= announceReq.numwant)
-                break;
-
-            if (peer.endpoint.size() == 6)  // IPv4
-                peerList.emplace_back(peer.endpoint);
-            else if (peer.endpoint.size() == 18)  // IPv6
-                peer6List.emplace_back(peer.endpoint);
-        }
+    // non-compact peer list
+    lt::entry::list_type peerList;
 
-        replyDict[ANNOUNCE_RESPONSE_PEERS] = peerList;  // required, even it's empty
-        if (!peer6List.empty())
-            replyDict[ANNOUNCE_RESPONSE_PEERS6] = peer6List;
-    }
-    else {
-        lt::entry::list_type peerList;
-
-        int counter = 0;
-        for (const Peer &peer : torrentStats.peers) {
-            if (counter++ >= announceReq.numwant)
-                break;
-
-            lt::entry::dictionary_type peerDict = {
-                {ANNOUNCE_RESPONSE_PEERS_IP, peer.address},
-                {ANNOUNCE_RESPONSE_PEERS_PORT, peer.port}
-            };
+    int counter = 0;
+    for (const Peer &peer : torrentStats.peers) {
+        if (counter++ >= announceReq.numwant)
+            break;
 
-            if (!announceReq.noPeerId)
-                peerDict[ANNOUNCE_RESPONSE_PEERS_PEER_ID] = peer.peerId.constData();
+        lt::entry::dictionary_type peerDict = {
+            {ANNOUNCE_RESPONSE_PEERS_IP, peer.address},
+            {ANNOUNCE_RESPONSE_PEERS_PORT, peer.port}
+        };
 
-            peerList.emplace_back(peerDict);
-        }
+        if (!announceReq.noPeerId)
+            peerDict[ANNOUNCE_RESPONSE_PEERS_PEER_ID] = peer.peerId.constData();
 
-        replyDict[ANNOUNCE_RESPONSE_PEERS] = peerList;
+        peerList.emplace_back(peerDict);
     }
 
+    replyDict[ANNOUNCE_RESPONSE_PEERS] = peerList;
+
     // bencode
     QByteArray reply;
     lt::bencode(std::back_inserter(reply), replyDict);
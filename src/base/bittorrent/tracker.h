@@ -35,14 +35,20 @@
 
 #include <libtorrent/entry.hpp>
 
+#include <QElapsedTimer>
 #include <QHash>
 #include <QObject>
 #include <QSet>
+#include <QVector>
 
 #include "base/bittorrent/infohash.h"
 #include "base/http/irequesthandler.h"
 #include "base/http/responsebuilder.h"
 
+class QHostAddress;
+class QTimer;
+class QUdpSocket;
+
 namespace Http
 {
     class Server;
@@ -55,6 +61,7 @@ namespace BitTorrent
         QByteArray peerId;
         ushort port = 0;  // self-claimed by peer, might not be the same as socket port
         bool isSeeder = false;
+        qint64 lastSeen = 0;  // seconds, since tracker start
 
         // caching precomputed values
         lt::entry::string_type address;
@@ -70,40 +77,100 @@ namespace BitTorrent
     // *Basic* Bittorrent tracker implementation
     // [BEP-3] The BitTorrent Protocol Specification
     // also see: https://wiki.theory.org/index.php/BitTorrentSpecification#Tracker_HTTP.2FHTTPS_Protocol
+    // [BEP-15] UDP Tracker Protocol for BitTorrent
     class Tracker : public QObject, public Http::IRequestHandler, private Http::ResponseBuilder
     {
         Q_OBJECT
         Q_DISABLE_COPY(Tracker)
 
         struct TrackerAnnounceRequest;
+        struct ExpirationEntry;
+
+        // Packed compact peer entries ([BEP-23] and [BEP-7]) of one address family
+        class CompactPeerList
+        {
+        public:
+            explicit CompactPeerList(int entrySize);
+
+            int size() const;
+            void add(const Peer &peer);
+            void remove(const Peer &peer);
+            // returns `count` entries starting at random position
+            QByteArray sample(int count) const;
+
+        private:
+            int m_entrySize;
+            QByteArray m_data;
+            QVector<QByteArray> m_entryOwners;
+            QHash<QByteArray, int> m_entryIndices;
+        };
 
         struct TorrentStats
         {
             qint64 seeders = 0;
+            qint64 completed = 0;  // "completed" events seen while the torrent is tracked
             QSet<Peer> peers;
+            CompactPeerList peers4 {6};
+            CompactPeerList peers6 {18};
 
-            void setPeer(const Peer &peer);
+            void setPeer(const Peer &peer, int maxPeers);
             bool removePeer(const Peer &peer);
         };
 
     public:
         explicit Tracker(QObject *parent = nullptr);
+        ~Tracker() override;
 
         bool start();
 
+        int torrentsCount() const;
+        int peersCount() const;
+
+    private slots:
+        void readPendingDatagrams();
+        void rotateConnectionSecret();
+        void removeExpiredPeers();
+
     private:
+        bool startHttpServer();
+        bool startUdpServer();
+
         Http::Response processRequest(const Http::Request &request, const Http::Environment &env) override;
         void processAnnounceRequest();
+        void processScrapeRequest();
+
+        QByteArray processUdpRequest(const QByteArray &datagram, const QHostAddress &address, quint16 port);
+        QByteArray processUdpAnnounceRequest(const QByteArray &datagram, const QHostAddress &address);
+        QByteArray processUdpScrapeRequest(const QByteArray &datagram);
+        quint64 udpConnectionID(quint64 secret, const QHostAddress &address, quint16 port) const;
 
         void registerPeer(const TrackerAnnounceRequest &announceReq);
         void unregisterPeer(const TrackerAnnounceRequest &announceReq);
         void prepareAnnounceResponse(const TrackerAnnounceRequest &announceReq);
+        void applyLimits();
+        qint64 currentTime() const;
 
         Http::Server *m_server;
         Http::Request m_request;
         Http::Environment m_env;
 
+        QUdpSocket *m_udpSocket;
+        QTimer *m_connectionSecretTimer;
+        quint64 m_connectionSecret;
+        quint64 m_prevConnectionSecret;
+
+        int m_maxTorrents;
+        int m_maxPeersPerTorrent;
+
+        // Timer wheel of peer expiration, each slot holds peers which were
+        // last seen about the same time. Refreshed peers are skipped lazily.
+        QElapsedTimer m_clock;
+        QTimer *m_expirationTimer;
+        QVector<QVector<ExpirationEntry>> m_expirationWheel;
+        int m_expirationWheelPos = 0;
+
         QHash<InfoHash, TorrentStats> m_torrents;
+        int m_peersCount = 0;
     };
 }
 
@@ -203,7 +203,7 @@ bool RequestParser::parseRequestLine(const QString &line)
             const QString paramName = QString::fromUtf8(QByteArray::fromPercentEncoding(nameComponent).replace('+', ' '));
             const QByteArray paramValue = QByteArray::fromPercentEncoding(valueComponent).replace('+', ' ');
 
-            m_request.query[paramName] = paramValue;
+            m_request.query.insert(paramName, paramValue);
         }
     }
 
@@ -72,6 +72,7 @@ namespace Http
     const char CONTENT_TYPE_PNG[] = "image/png";
     const char CONTENT_TYPE_FORM_ENCODED[] = "application/x-www-form-urlencoded";
     const char CONTENT_TYPE_FORM_DATA[] = "multipart/form-data";
+    const char CONTENT_TYPE_OCTET_STREAM[] = "application/octet-stream";
 
     // portability: "\r\n" doesn't guarantee mapping to the correct symbol
     const char CRLF[] = {0x0D, 0x0A, '\0'};
@@ -98,7 +99,7 @@ namespace Http
         QString method;
         QString path;
         QStringMap headers;
-        QHash<QString, QByteArray> query;
+        QMultiHash<QString, QByteArray> query;  // value() returns the last occurrence
         QHash<QString, QString> posts;
         QVector<UploadedFile> files;
     };
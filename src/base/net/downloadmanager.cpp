@@ -119,8 +119,14 @@ namespace
 
         // Spoof HTTP Referer to allow adding torrent link from Torcache/KickAssTorrents
         request.setRawHeader("Referer", request.url().toEncoded().data());
-        // Accept gzip
-        request.setRawHeader("Accept-Encoding", "gzip");
+        // Accept gzip. Streamed data can't be decompressed at once,
+        // so let Qt negotiate the encoding and decompress it on the fly.
+        if (!downloadRequest.streaming())
+            request.setRawHeader("Accept-Encoding", "gzip");
+        if (!downloadRequest.ifNoneMatch().isEmpty())
+            request.setRawHeader("If-None-Match", downloadRequest.ifNoneMatch().toLatin1());
+        if (!downloadRequest.ifModifiedSince().isEmpty())
+            request.setRawHeader("If-Modified-Since", downloadRequest.ifModifiedSince().toLatin1());
         // Qt doesn't support Magnet protocol so we need to handle redirections manually
         request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::ManualRedirectPolicy);
 
@@ -336,6 +342,39 @@ Net::DownloadRequest &Net::DownloadRequest::saveToFile(const bool value)
     return *this;
 }
 
+bool Net::DownloadRequest::streaming() const
+{
+    return m_streaming;
+}
+
+Net::DownloadRequest &Net::DownloadRequest::streaming(const bool value)
+{
+    m_streaming = value;
+    return *this;
+}
+
+QString Net::DownloadRequest::ifNoneMatch() const
+{
+    return m_ifNoneMatch;
+}
+
+Net::DownloadRequest &Net::DownloadRequest::ifNoneMatch(const QString &value)
+{
+    m_ifNoneMatch = value;
+    return *this;
+}
+
+QString Net::DownloadRequest::ifModifiedSince() const
+{
+    return m_ifModifiedSince;
+}
+
+Net::DownloadRequest &Net::DownloadRequest::ifModifiedSince(const QString &value)
+{
+    m_ifModifiedSince = value;
+    return *this;
+}
+
 Net::ServiceID Net::ServiceID::fromURL(const QUrl &url)
 {
     return {url.host(), url.port(80)};
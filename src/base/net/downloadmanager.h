@@ -58,6 +58,7 @@ namespace Net
     {
         Success,
         RedirectedToMagnet,
+        NotModified, // only for conditional requests
         Failed
     };
 
@@ -79,11 +80,25 @@ namespace Net
         bool saveToFile() const;
         DownloadRequest &saveToFile(bool value);
 
+        // Emit data as it arrives (via DownloadHandler::dataReceived) instead of
+        // collecting it in DownloadResult::data
+        bool streaming() const;
+        DownloadRequest &streaming(bool value);
+
+        // Make the request conditional, using validators of previously downloaded content
+        QString ifNoneMatch() const;
+        DownloadRequest &ifNoneMatch(const QString &value);
+        QString ifModifiedSince() const;
+        DownloadRequest &ifModifiedSince(const QString &value);
+
     private:
         QString m_url;
         QString m_userAgent;
         qint64 m_limit = 0;
         bool m_saveToFile = false;
+        bool m_streaming = false;
+        QString m_ifNoneMatch;
+        QString m_ifModifiedSince;
     };
 
     struct DownloadResult
@@ -94,6 +109,9 @@ namespace Net
         QByteArray data;
         QString filePath;
         QString magnet;
+        // Validators of downloaded content (for conditional requests)
+        QString eTag;
+        QString lastModified;
     };
 
     class DownloadHandler : public QObject
@@ -107,6 +125,9 @@ namespace Net
         virtual void cancel() = 0;
 
     signals:
+        // Emitted for streaming requests once the response headers of successful reply are known
+        void validatorsReceived(const QString &eTag, const QString &lastModified);
+        void dataReceived(const QByteArray &data);
         void finished(const DownloadResult &result);
     };
 
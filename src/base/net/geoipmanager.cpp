@@ -137,6 +137,14 @@ QString GeoIPManager::lookup(const QHostAddress &hostAddr) const
     return {};
 }
 
+QVector<QString> GeoIPManager::lookup(const QVector<QHostAddress> &hostAddrs) const
+{
+    if (m_enabled && m_geoIPDatabase)
+        return m_geoIPDatabase->lookup(hostAddrs);
+
+    return QVector<QString>(hostAddrs.size());
+}
+
 QString GeoIPManager::CountryName(const QString &countryISOCode)
 {
     static const QHash<QString, QString> countries = {
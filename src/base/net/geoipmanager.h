@@ -31,6 +31,7 @@
 #define NET_GEOIPMANAGER_H
 
 #include <QObject>
+#include <QVector>
 
 class QHostAddress;
 class QString;
@@ -52,6 +53,7 @@ namespace Net
         static GeoIPManager *instance();
 
         QString lookup(const QHostAddress &hostAddr) const;
+        QVector<QString> lookup(const QVector<QHostAddress> &hostAddrs) const;
 
         static QString CountryName(const QString &countryISOCode);
 
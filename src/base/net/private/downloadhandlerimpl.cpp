@@ -71,7 +71,10 @@ DownloadHandlerImpl::~DownloadHandlerImpl()
 
 void DownloadHandlerImpl::cancel()
 {
-    if (m_reply) {
+    if (m_redirectedHandler) {
+        m_redirectedHandler->cancel();
+    }
+    else if (m_reply) {
         m_reply->abort();
     }
     else {
@@ -88,6 +91,8 @@ void DownloadHandlerImpl::assignNetworkReply(QNetworkReply *reply)
     m_reply->setParent(this);
     if (m_downloadRequest.limit() > 0)
         connect(m_reply, &QNetworkReply::downloadProgress, this, &DownloadHandlerImpl::checkDownloadSize);
+    if (m_downloadRequest.streaming())
+        connect(m_reply, &QNetworkReply::readyRead, this, &DownloadHandlerImpl::processReceivedData);
     connect(m_reply, &QNetworkReply::finished, this, &DownloadHandlerImpl::processFinishedDownload);
 }
 
@@ -102,6 +107,28 @@ const Net::DownloadRequest DownloadHandlerImpl::downloadRequest() const
     return m_downloadRequest;
 }
 
+void DownloadHandlerImpl::processReceivedData()
+{
+    // Content of redirection and error responses is of no interest
+    const QVariant statusCode = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+    if (statusCode.isValid() && ((statusCode.toInt() < 200) || (statusCode.toInt() >= 300)))
+        return;
+
+    processValidators();
+    emit dataReceived(m_reply->readAll());
+}
+
+void DownloadHandlerImpl::processValidators()
+{
+    if (m_hasValidators) return;
+
+    m_hasValidators = true;
+    m_result.eTag = QString::fromLatin1(m_reply->rawHeader("ETag"));
+    m_result.lastModified = QString::fromLatin1(m_reply->rawHeader("Last-Modified"));
+    if (m_downloadRequest.streaming())
+        emit validatorsReceived(m_result.eTag, m_result.lastModified);
+}
+
 void DownloadHandlerImpl::processFinishedDownload()
 {
     qDebug("Download finished: %s", qUtf8Printable(url()));
@@ -122,7 +149,24 @@ void DownloadHandlerImpl::processFinishedDownload()
         return;
     }
 
+    if (m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304) {
+        m_result.status = Net::DownloadStatus::NotModified;
+        finish();
+        return;
+    }
+
     // Success
+    processValidators();
+
+    if (m_downloadRequest.streaming()) {
+        const QByteArray remainingData = m_reply->readAll();
+        if (!remainingData.isEmpty())
+            emit dataReceived(remainingData);
+
+        finish();
+        return;
+    }
+
     m_result.data = (m_reply->rawHeader("Content-Encoding") == "gzip")
                     ? Utils::Gzip::decompress(m_reply->readAll())
                     : m_reply->readAll();
@@ -182,6 +226,9 @@ void DownloadHandlerImpl::handleRedirection(const QUrl &newUrl)
     auto redirected = static_cast<DownloadHandlerImpl *>(
                 m_manager->download(Net::DownloadRequest(m_downloadRequest).url(newUrlString)));
     redirected->m_redirectionCount = m_redirectionCount + 1;
+    m_redirectedHandler = redirected;
+    connect(redirected, &DownloadHandler::validatorsReceived, this, &DownloadHandler::validatorsReceived);
+    connect(redirected, &DownloadHandler::dataReceived, this, &DownloadHandler::dataReceived);
     connect(redirected, &DownloadHandlerImpl::finished, this, [this](const Net::DownloadResult &result)
     {
         m_result = result;
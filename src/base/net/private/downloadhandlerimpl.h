@@ -30,6 +30,7 @@
 #pragma once
 
 #include <QNetworkReply>
+#include <QPointer>
 
 #include "base/net/downloadmanager.h"
 
@@ -53,6 +54,8 @@ public:
     void assignNetworkReply(QNetworkReply *reply);
 
 private:
+    void processReceivedData();
+    void processValidators();
     void processFinishedDownload();
     void checkDownloadSize(qint64 bytesReceived, qint64 bytesTotal);
     void handleRedirection(const QUrl &newUrl);
@@ -63,7 +66,9 @@ private:
 
     Net::DownloadManager *m_manager = nullptr;
     QNetworkReply *m_reply = nullptr;
+    QPointer<DownloadHandlerImpl> m_redirectedHandler;
     const Net::DownloadRequest m_downloadRequest;
     short m_redirectionCount = 0;
+    bool m_hasValidators = false;
     Net::DownloadResult m_result;
 };
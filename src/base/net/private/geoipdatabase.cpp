@@ -28,14 +28,17 @@
 
 #include "geoipdatabase.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include "base/global.h"
 #include "base/types.h"
 
 #include <QDebug>
 #include <QHash>
 #include <QHostAddress>
 #include <QFile>
-
-#include "geoipdatabase.h"
+#include <QMutexLocker>
 
 #include <boost/numeric/conversion/cast.hpp>
 
@@ -45,6 +48,23 @@ namespace
     const quint32 MAX_METADATA_SIZE = 131072; // 128KB
     const char METADATA_BEGIN_MARK[] = "\xab\xcd\xefMaxMind.com";
     const char DATA_SECTION_SEPARATOR[16] = {0};
+    // 24 bit table would take 64 MiB
+    const int JUMP_TABLE_BITS = 16;
+    const int MAX_RECENT_LOOKUPS = 4096;
+
+    bool addressBit(const Q_IPV6ADDR &addr, const int bit)
+    {
+        return (((addr[bit / 8] >> (7 - (bit % 8))) & 1) != 0);
+    }
+
+    bool isIPv4Mapped(const Q_IPV6ADDR &addr)
+    {
+        for (int i = 0; i < 10; ++i) {
+            if (addr[i] != 0)
+                return false;
+        }
+        return ((addr[10] == 0xFF) && (addr[11] == 0xFF));
+    }
 
     enum class DataType
     {
@@ -77,42 +97,55 @@ struct DataFieldDescriptor
     };
 };
 
-GeoIPDatabase::GeoIPDatabase(const quint32 size)
+GeoIPDatabase::GeoIPDatabase()
     : m_ipVersion(0)
     , m_recordSize(0)
     , m_nodeCount(0)
     , m_nodeSize(0)
     , m_indexSize(0)
     , m_recordBytes(0)
-    , m_size(size)
-    , m_data(new uchar[size])
+    , m_recentLookups(MAX_RECENT_LOOKUPS)
+    , m_file(nullptr)
+    , m_size(0)
+    , m_data(nullptr)
 {
 }
 
 GeoIPDatabase *GeoIPDatabase::load(const QString &filename, QString &error)
 {
-    GeoIPDatabase *db = nullptr;
-    QFile file(filename);
-    if (file.size() > MAX_FILE_SIZE) {
+    auto *file = new QFile(filename);
+    if (file->size() > MAX_FILE_SIZE) {
         error = tr("Unsupported database file size.");
+        delete file;
         return nullptr;
     }
 
-    if (!file.open(QFile::ReadOnly)) {
-        error = file.errorString();
+    if (!file->open(QFile::ReadOnly)) {
+        error = file->errorString();
+        delete file;
         return nullptr;
     }
 
-    db = new GeoIPDatabase(file.size());
+    auto *db = new GeoIPDatabase;
+    db->m_size = static_cast<quint32>(file->size());
 
-    if (file.read(reinterpret_cast<char *>(db->m_data), db->m_size) != db->m_size) {
-        error = file.errorString();
-        delete db;
-        return nullptr;
+    // The file stays mapped (and open) during the lifetime of the database
+    bool isRead = true;
+    const uchar *data = file->map(0, db->m_size);
+    if (data) {
+        db->m_file = file;
+        db->m_data = data;
+    }
+    else {
+        db->m_buffer = file->readAll();
+        isRead = (db->m_buffer.size() == static_cast<int>(db->m_size));
+        if (!isRead)
+            error = file->errorString();
+        db->m_data = reinterpret_cast<const uchar *>(db->m_buffer.constData());
+        delete file;
     }
 
-
-    if (!db->parseMetadata(db->readMetadata(), error) || !db->loadDB(error)) {
+    if (!isRead || !db->init(error)) {
         delete db;
         return nullptr;
     }
@@ -122,17 +155,18 @@ GeoIPDatabase *GeoIPDatabase::load(const QString &filename, QString &error)
 
 GeoIPDatabase *GeoIPDatabase::load(const QByteArray &data, QString &error)
 {
-    GeoIPDatabase *db = nullptr;
     if (data.size() > MAX_FILE_SIZE) {
         error = tr("Unsupported database file size.");
         return nullptr;
     }
 
-    db = new GeoIPDatabase(static_cast<unsigned>(data.size()));
+    auto *db = new GeoIPDatabase;
+    // shares data with the caller instead of copying it
+    db->m_buffer = data;
+    db->m_size = static_cast<quint32>(data.size());
+    db->m_data = reinterpret_cast<const uchar *>(db->m_buffer.constData());
 
-    memcpy(reinterpret_cast<char *>(db->m_data), data.constData(), db->m_size);
-
-    if (!db->parseMetadata(db->readMetadata(), error) || !db->loadDB(error)) {
+    if (!db->init(error)) {
         delete db;
         return nullptr;
     }
@@ -142,7 +176,16 @@ GeoIPDatabase *GeoIPDatabase::load(const QByteArray &data, QString &error)
 
 GeoIPDatabase::~GeoIPDatabase()
 {
-    delete [] m_data;
+    delete m_file;
+}
+
+bool GeoIPDatabase::init(QString &error)
+{
+    if (!parseMetadata(readMetadata(), error) || !loadDB(error))
+        return false;
+
+    buildJumpTables();
+    return true;
 }
 
 QString GeoIPDatabase::type() const
@@ -162,44 +205,164 @@ QDateTime GeoIPDatabase::buildEpoch() const
 
 QString GeoIPDatabase::lookup(const QHostAddress &hostAddr) const
 {
-    Q_IPV6ADDR addr = hostAddr.toIPv6Address();
-
-    const uchar *ptr = m_data;
-
-    for (int i = 0; i < 16; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            const bool right = static_cast<bool>((addr[i] >> (7 - j)) & 1);
-            // Interpret the left/right record as number
-            if (right)
-                ptr += m_recordBytes;
-
-            quint32 id = 0;
-            auto *idPtr = reinterpret_cast<uchar *>(&id);
-            memcpy(&idPtr[4 - m_recordBytes], ptr, m_recordBytes);
-            fromBigEndian(idPtr, 4);
-
-            if (id == m_nodeCount) {
-                return {};
-            }
-            if (id > m_nodeCount) {
-                QString country = m_countries.value(id);
-                if (country.isEmpty()) {
-                    const quint32 offset = id - m_nodeCount - sizeof(DATA_SECTION_SEPARATOR);
-                    quint32 tmp = offset + m_indexSize + sizeof(DATA_SECTION_SEPARATOR);
-                    const QVariant val = readDataField(tmp);
-                    if (val.userType() == QMetaType::QVariantHash) {
-                        country = val.toHash()["country"].toHash()["iso_code"].toString();
-                        m_countries[id] = country;
-                    }
-                }
-                return country;
-            }
-
-            ptr = m_data + (id * m_nodeSize);
+    const Q_IPV6ADDR addr = hostAddr.toIPv6Address();
+
+    QPair<quint64, quint64> key;
+    std::memcpy(&key.first, &addr[0], sizeof(key.first));
+    std::memcpy(&key.second, &addr[8], sizeof(key.second));
+    {
+        const QMutexLocker locker {&m_cacheMutex};
+        if (const QString *country = m_recentLookups.object(key))
+            return *country;
+    }
+
+    // Skip the first 16 bits (of IPv4 part for IPv4-mapped addresses) using the jump tables
+    quint32 id = 0;
+    int bit = 0;
+    if (isIPv4Mapped(addr)) {
+        id = m_ipv4JumpTable[(addr[12] << 8) | addr[13]];
+        bit = 96 + JUMP_TABLE_BITS;
+    }
+    else {
+        id = m_jumpTable[(addr[0] << 8) | addr[1]];
+        bit = JUMP_TABLE_BITS;
+    }
+
+    for (; (bit < 128) && (id < m_nodeCount); ++bit)
+        id = readRecord(id, addressBit(addr, bit));
+
+    const QString country = (id > m_nodeCount) ? countryFromRecord(id) : QString();
+
+    const QMutexLocker locker {&m_cacheMutex};
+    m_recentLookups.insert(key, new QString(country));
+    return country;
+}
+
+QVector<QString> GeoIPDatabase::lookup(const QVector<QHostAddress> &hostAddrs) const
+{
+    const int count = hostAddrs.size();
+    QVector<Q_IPV6ADDR> addrs;
+    addrs.reserve(count);
+    QVector<int> order;
+    order.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        addrs.append(hostAddrs[i].toIPv6Address());
+        order.append(i);
+    }
+
+    std::sort(order.begin(), order.end(), [&addrs](const int left, const int right)
+    {
+        return (std::memcmp(&addrs.at(left), &addrs.at(right), sizeof(Q_IPV6ADDR)) < 0);
+    });
+
+    // path[bit] is the node id before bit `bit` was consumed by the previous walk,
+    // it is valid for bits in range [pathBegin, pathEnd]
+    quint32 path[129];
+    int pathBegin = 0;
+    int pathEnd = -1;
+    const Q_IPV6ADDR *prevAddr = nullptr;
+
+    QHash<quint32, QString> countries;  // avoids locking for every address
+    QVector<QString> result(count);
+    for (const int index : asConst(order)) {
+        const Q_IPV6ADDR &addr = addrs.at(index);
+
+        int commonBits = 0;
+        if (prevAddr) {
+            while ((commonBits < 128) && (addressBit(addr, commonBits) == addressBit(*prevAddr, commonBits)))
+                ++commonBits;
+        }
+        prevAddr = &addr;
+
+        int bit = std::min(commonBits, pathEnd);
+        quint32 id = 0;
+        if (bit >= pathBegin) {
+            id = path[bit];
+        }
+        else if (isIPv4Mapped(addr)) {
+            bit = 96 + JUMP_TABLE_BITS;
+            id = m_ipv4JumpTable[(addr[12] << 8) | addr[13]];
+            pathBegin = bit;
+        }
+        else {
+            bit = JUMP_TABLE_BITS;
+            id = m_jumpTable[(addr[0] << 8) | addr[1]];
+            pathBegin = bit;
+        }
+
+        for (; (bit < 128) && (id < m_nodeCount); ++bit) {
+            path[bit] = id;
+            id = readRecord(id, addressBit(addr, bit));
+        }
+        path[bit] = id;
+        pathEnd = bit;
+
+        if (id > m_nodeCount) {
+            auto countryIter = countries.find(id);
+            if (countryIter == countries.end())
+                countryIter = countries.insert(id, countryFromRecord(id));
+            result[index] = countryIter.value();
         }
     }
 
-    return {};
+    return result;
+}
+
+quint32 GeoIPDatabase::readRecord(const quint32 nodeId, const bool right) const
+{
+    // record size is always 24 bits (see parseMetadata())
+    const uchar *ptr = m_data + (nodeId * m_nodeSize) + (right ? m_recordBytes : 0);
+    return ((static_cast<quint32>(ptr[0]) << 16) | (static_cast<quint32>(ptr[1]) << 8) | ptr[2]);
+}
+
+QString GeoIPDatabase::countryFromRecord(const quint32 recordId) const
+{
+    {
+        const QMutexLocker locker {&m_cacheMutex};
+        const auto iter = m_countries.constFind(recordId);
+        if (iter != m_countries.cend())
+            return iter.value();
+    }
+
+    QString country;
+    const quint32 offset = recordId - m_nodeCount - sizeof(DATA_SECTION_SEPARATOR);
+    quint32 tmp = offset + m_indexSize + sizeof(DATA_SECTION_SEPARATOR);
+    const QVariant val = readDataField(tmp);
+    if (val.userType() == QMetaType::QVariantHash)
+        country = val.toHash()["country"].toHash()["iso_code"].toString();
+
+    // there are only a few distinct records (one per country)
+    const QMutexLocker locker {&m_cacheMutex};
+    m_countries.insert(recordId, country);
+    return country;
+}
+
+void GeoIPDatabase::buildJumpTables()
+{
+    m_jumpTable.assign((1u << JUMP_TABLE_BITS), m_nodeCount);
+    fillJumpTable(m_jumpTable, 0, 0, 0);
+
+    // IPv4-mapped addresses (::ffff:0:0/96) have their own subtree
+    quint32 ipv4Root = 0;
+    for (int bit = 0; (bit < 96) && (ipv4Root < m_nodeCount); ++bit)
+        ipv4Root = readRecord(ipv4Root, (bit >= 80));
+
+    m_ipv4JumpTable.assign((1u << JUMP_TABLE_BITS), m_nodeCount);
+    fillJumpTable(m_ipv4JumpTable, ipv4Root, 0, 0);
+}
+
+void GeoIPDatabase::fillJumpTable(std::vector<quint32> &table, const quint32 nodeId, const int depth, const quint32 prefix) const
+{
+    if ((nodeId >= m_nodeCount) || (depth == JUMP_TABLE_BITS)) {
+        // all addresses with this prefix end up in the same node or record
+        const quint32 first = prefix << (JUMP_TABLE_BITS - depth);
+        const quint32 count = 1u << (JUMP_TABLE_BITS - depth);
+        std::fill_n((table.begin() + first), count, nodeId);
+        return;
+    }
+
+    fillJumpTable(table, readRecord(nodeId, false), (depth + 1), (prefix << 1));
+    fillJumpTable(table, readRecord(nodeId, true), (depth + 1), ((prefix << 1) | 1));
 }
 
 #define CHECK_METADATA_REQ(key, type) \
@@ -29,11 +29,18 @@
 #ifndef GEOIPDATABASE_H
 #define GEOIPDATABASE_H
 
+#include <vector>
+
+#include <QByteArray>
+#include <QCache>
 #include <QCoreApplication>
 #include <QDateTime>
+#include <QMutex>
+#include <QPair>
 #include <QVariant>
+#include <QVector>
 
-class QByteArray;
+class QFile;
 class QHostAddress;
 
 struct DataFieldDescriptor;
@@ -51,14 +58,23 @@ public:
     QString type() const;
     quint16 ipVersion() const;
     QDateTime buildEpoch() const;
+    // thread-safe
     QString lookup(const QHostAddress &hostAddr) const;
+    // Resolves addresses in sorted order so neighbours share the walked part of the tree.
+    // Equal country codes share the same string data.
+    QVector<QString> lookup(const QVector<QHostAddress> &hostAddrs) const;
 
 private:
-    explicit GeoIPDatabase(quint32 size);
+    GeoIPDatabase();
 
+    bool init(QString &error);
     bool parseMetadata(const QVariantHash &metadata, QString &error);
     bool loadDB(QString &error) const;
     QVariantHash readMetadata() const;
+    void buildJumpTables();
+    void fillJumpTable(std::vector<quint32> &table, quint32 nodeId, int depth, quint32 prefix) const;
+    quint32 readRecord(quint32 nodeId, bool right) const;
+    QString countryFromRecord(quint32 recordId) const;
 
     QVariant readDataField(quint32 &offset) const;
     bool readDataFieldDescriptor(quint32 &offset, DataFieldDescriptor &out) const;
@@ -94,9 +110,17 @@ private:
     QDateTime m_buildEpoch;
     QString m_dbType;
     // Search data
+    // nodes reached after the first 16 bits of IPv6 and IPv4 (mapped) addresses
+    std::vector<quint32> m_jumpTable;
+    std::vector<quint32> m_ipv4JumpTable;
+    mutable QMutex m_cacheMutex;
     mutable QHash<quint32, QString> m_countries;
+    mutable QCache<QPair<quint64, quint64>, QString> m_recentLookups;
+    // Database file is mapped if possible
+    QFile *m_file;
+    QByteArray m_buffer;
     quint32 m_size;
-    uchar *m_data;
+    const uchar *m_data;
 };
 
 #endif // GEOIPDATABASE_H
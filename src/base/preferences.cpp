@@ -1085,6 +1085,36 @@ void Preferences::setTrackerPort(const int port)
     setValue("Preferences/Advanced/trackerPort", port);
 }
 
+int Preferences::getTrackerUDPPort() const
+{
+    return value("Preferences/Advanced/trackerUDPPort", 0).toInt();
+}
+
+void Preferences::setTrackerUDPPort(const int port)
+{
+    setValue("Preferences/Advanced/trackerUDPPort", port);
+}
+
+int Preferences::getTrackerMaxTorrents() const
+{
+    return value("Preferences/Advanced/trackerMaxTorrents", 10000).toInt();
+}
+
+void Preferences::setTrackerMaxTorrents(const int count)
+{
+    setValue("Preferences/Advanced/trackerMaxTorrents", count);
+}
+
+int Preferences::getTrackerMaxPeersPerTorrent() const
+{
+    return value("Preferences/Advanced/trackerMaxPeersPerTorrent", 200).toInt();
+}
+
+void Preferences::setTrackerMaxPeersPerTorrent(const int count)
+{
+    setValue("Preferences/Advanced/trackerMaxPeersPerTorrent", count);
+}
+
 #if defined(Q_OS_WIN) || defined(Q_OS_MACOS)
 bool Preferences::isUpdateCheckEnabled() const
 {
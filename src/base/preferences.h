@@ -289,6 +289,12 @@ public:
 #endif
     int getTrackerPort() const;
     void setTrackerPort(int port);
+    int getTrackerUDPPort() const;
+    void setTrackerUDPPort(int port);
+    int getTrackerMaxTorrents() const;
+    void setTrackerMaxTorrents(int count);
+    int getTrackerMaxPeersPerTorrent() const;
+    void setTrackerMaxPeersPerTorrent(int count);
 #if defined(Q_OS_WIN) || defined(Q_OS_MACOS)
     bool isUpdateCheckEnabled() const;
     void setUpdateCheckEnabled(bool enabled);
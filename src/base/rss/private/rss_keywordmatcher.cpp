@@ -0,0 +1,127 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2020  Eugene Shalygin <eugene.shalygin@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "rss_keywordmatcher.h"
+
+#include <algorithm>
+#include <queue>
+
+using namespace RSS::Private;
+
+KeywordMatcher::Node::Node()
+{
+    std::fill(std::begin(next), std::end(next), -1);
+}
+
+bool KeywordMatcher::isKeywordChar(const QChar c)
+{
+    return (symbolOf(c) >= 0);
+}
+
+int KeywordMatcher::symbolOf(const QChar c)
+{
+    // Titles are matched case insensitively, so non-ASCII characters folding
+    // to ASCII ones (e.g. KELVIN SIGN) must be treated as the latter
+    const ushort ch = ((c.unicode() < 128) ? c : c.toCaseFolded()).unicode();
+    if ((ch >= 'a') && (ch <= 'z'))
+        return (ch - 'a');
+    if ((ch >= 'A') && (ch <= 'Z'))
+        return (ch - 'A');
+    if ((ch >= '0') && (ch <= '9'))
+        return (26 + ch - '0');
+    return -1;
+}
+
+void KeywordMatcher::addKeyword(const QString &keyword, const int id)
+{
+    Q_ASSERT(!keyword.isEmpty());
+
+    int state = 0;
+    for (const QChar c : keyword) {
+        const int symbol = symbolOf(c);
+        Q_ASSERT(symbol >= 0);
+
+        if (m_nodes[state].next[symbol] < 0) {
+            m_nodes[state].next[symbol] = static_cast<int>(m_nodes.size());
+            m_nodes.emplace_back();
+        }
+        state = m_nodes[state].next[symbol];
+    }
+
+    m_nodes[state].ids.append(id);
+}
+
+void KeywordMatcher::build()
+{
+    // Turn the trie into a complete transition table in breadth-first order,
+    // so every state can be left in a single step while matching
+    std::queue<int> queue;
+    for (int &child : m_nodes[0].next) {
+        if (child < 0) {
+            child = 0;
+        }
+        else {
+            m_nodes[child].fail = 0;
+            queue.push(child);
+        }
+    }
+
+    while (!queue.empty()) {
+        const int state = queue.front();
+        queue.pop();
+
+        const int fail = m_nodes[state].fail;
+        m_nodes[state].outputLink = m_nodes[fail].ids.isEmpty() ? m_nodes[fail].outputLink : fail;
+
+        for (int symbol = 0; symbol < AlphabetSize; ++symbol) {
+            const int child = m_nodes[state].next[symbol];
+            if (child < 0) {
+                m_nodes[state].next[symbol] = m_nodes[fail].next[symbol];
+            }
+            else {
+                m_nodes[child].fail = m_nodes[fail].next[symbol];
+                queue.push(child);
+            }
+        }
+    }
+}
+
+void KeywordMatcher::match(const QString &text, QVector<bool> &found) const
+{
+    int state = 0;
+    for (const QChar c : text) {
+        const int symbol = symbolOf(c);
+        // keywords never contain other characters, so no match can span them
+        state = (symbol >= 0) ? m_nodes[state].next[symbol] : 0;
+
+        for (int output = state; output > 0; output = m_nodes[output].outputLink) {
+            for (const int id : m_nodes[output].ids)
+                found[id] = true;
+        }
+    }
+}
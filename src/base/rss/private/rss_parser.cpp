@@ -29,6 +29,9 @@
 
 #include "rss_parser.h"
 
+#include <algorithm>
+
+#include <QCryptographicHash>
 #include <QDateTime>
 #include <QDebug>
 #include <QGlobalStatic>
@@ -40,6 +43,7 @@
 #include <QXmlStreamEntityResolver>
 #include <QXmlStreamReader>
 
+#include "../../global.h"
 #include "../rss_article.h"
 
 namespace
@@ -524,242 +528,427 @@ using namespace RSS::Private;
 
 const int ParsingResultTypeId = qRegisterMetaType<ParsingResult>();
 
+namespace
+{
+    // Number of already known articles in a row after which
+    // the rest of the feed is supposed to be known as well
+    const int KNOWN_ARTICLES_TO_STOP = 5;
+    // Feed data is compared with the last parsed one by blocks of this size
+    const int DATA_BLOCK_SIZE = 16 * 1024;
+}
+
 Parser::Parser(const QString lastBuildDate)
+    : m_lastBuildDate {lastBuildDate}
 {
-    m_result.lastBuildDate = lastBuildDate;
 }
 
-void Parser::parse(const QByteArray &feedData)
+void Parser::startParsing(const int parsingID, const QStringList &knownArticleIDs)
 {
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
-    QMetaObject::invokeMethod(this, [this, feedData]() { parse_impl(feedData); }
+    QMetaObject::invokeMethod(this, [this, parsingID, knownArticleIDs]() { startParsing_impl(parsingID, knownArticleIDs); }
                               , Qt::QueuedConnection);
 #else
-    QMetaObject::invokeMethod(this, "parse_impl", Qt::QueuedConnection
-                              , Q_ARG(QByteArray, feedData));
+    QMetaObject::invokeMethod(this, "startParsing_impl", Qt::QueuedConnection
+                              , Q_ARG(int, parsingID), Q_ARG(QStringList, knownArticleIDs));
 #endif
 }
 
-// read and create items from a rss document
-void Parser::parse_impl(const QByteArray &feedData)
+void Parser::addData(const QByteArray &data)
 {
-    QXmlStreamReader xml(feedData);
-    XmlStreamEntityResolver resolver;
-    xml.setEntityResolver(&resolver);
-    bool foundChannel = false;
-
-    while (xml.readNextStartElement()) {
-        if (xml.name() == "rss") {
-            // Find channels
-            while (xml.readNextStartElement()) {
-                if (xml.name() == "channel") {
-                    parseRSSChannel(xml);
-                    foundChannel = true;
-                    break;
-                }
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+    QMetaObject::invokeMethod(this, [this, data]() { addData_impl(data); }
+                              , Qt::QueuedConnection);
+#else
+    QMetaObject::invokeMethod(this, "addData_impl", Qt::QueuedConnection
+                              , Q_ARG(QByteArray, data));
+#endif
+}
 
-                qDebug() << "Skip rss item: " << xml.name();
-                xml.skipCurrentElement();
-            }
-            break;
-        }
-        if (xml.name() == "feed") { // Atom feed
-            parseAtomChannel(xml);
-            foundChannel = true;
-            break;
+void Parser::finishParsing()
+{
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+    QMetaObject::invokeMethod(this, [this]() { finishParsing_impl(); }
+                              , Qt::QueuedConnection);
+#else
+    QMetaObject::invokeMethod(this, "finishParsing_impl", Qt::QueuedConnection);
+#endif
+}
+
+void Parser::startParsing_impl(const int parsingID, const QStringList &knownArticleIDs)
+{
+    static XmlStreamEntityResolver resolver;
+
+    m_xml.clear();
+    m_xml.setEntityResolver(&resolver);
+
+    m_parsingID = parsingID;
+    m_isFinished = false;
+    m_isParsing = true;
+    m_format = FeedFormat::Unknown;
+    m_depth = 0;
+    m_channelDepth = 0;
+    m_articleDepth = 0;
+    m_authorDepth = 0;
+    m_textDepth = 0;
+    m_text.clear();
+    m_baseUrl.clear();
+    m_result.error.clear();
+    m_result.lastBuildDate.clear();
+    m_result.articles.clear();
+    m_parsedArticles.clear();
+    m_articleIDs.clear();
+    m_knownArticleIDs = List::toSet(knownArticleIDs);
+    m_knownArticlesInRow = 0;
+    m_isNewestFirst = true;
+    m_lastArticleDate = {};
+
+    m_blockHash.reset();
+    m_receivedBlockHashes.clear();
+    m_receivedSize = 0;
+    m_bufferedData.clear();
+    // Parsing is postponed as long as the data is the same as the last parsed one
+    m_isBuffering = !m_dataBlockHashes.isEmpty();
+}
+
+void Parser::addData_impl(const QByteArray &data)
+{
+    if (m_isFinished) return;
+
+    hashReceivedData(data);
+
+    if (m_isBuffering) {
+        const bool isSameData = (m_receivedSize <= m_dataSize)
+                && std::equal(m_receivedBlockHashes.cbegin(), m_receivedBlockHashes.cend(), m_dataBlockHashes.cbegin());
+        if (isSameData) {
+            m_bufferedData += data;
+            return;
         }
 
-        qDebug() << "Skip root item: " << xml.name();
-        xml.skipCurrentElement();
+        m_isBuffering = false;
+        m_xml.addData(m_bufferedData);
+        m_bufferedData.clear();
     }
 
-    if (!foundChannel) {
-        m_result.error = tr("Invalid RSS feed.");
-    }
-    else if (xml.hasError()) {
-        m_result.error = tr("%1 (line: %2, column: %3, offset: %4).")
-                .arg(xml.errorString()).arg(xml.lineNumber())
-                .arg(xml.columnNumber()).arg(xml.characterOffset());
-    }
+    if (!m_isParsing) return; // the rest of data is of no interest
 
-    emit finished(m_result);
-    m_result.articles.clear(); // clear articles only
-    m_articleIDs.clear();
+    m_xml.addData(data);
+    parseAvailableData();
+
+    if (!m_isFinished && !m_parsedArticles.isEmpty()) {
+        emit articlesParsed(m_parsingID, m_parsedArticles);
+        m_parsedArticles.clear();
+    }
 }
 
-void Parser::parseRssArticle(QXmlStreamReader &xml)
+void Parser::finishParsing_impl()
 {
-    QVariantHash article;
-    QString altTorrentUrl;
+    if (m_isFinished) return;
 
-    while (!xml.atEnd()) {
-        xml.readNext();
-        const QString name(xml.name().toString());
+    if ((m_receivedSize % DATA_BLOCK_SIZE) != 0)
+        m_receivedBlockHashes.append(m_blockHash.result());
 
-        if (xml.isEndElement() && (name == QLatin1String("item")))
-            break;
+    if (m_isBuffering && (m_receivedSize == m_dataSize) && (m_receivedBlockHashes == m_dataBlockHashes)) {
+        // The feed is the same as the last time, so there is nothing new in it
+        qDebug() << "The RSS feed data has not changed since last time, skip parsing.";
+        m_isParsing = false;
+        m_bufferedData.clear();
+        finish();
+        return;
+    }
 
-        if (xml.isStartElement()) {
-            if (name == QLatin1String("title")) {
-                article[Article::KeyTitle] = xml.readElementText().trimmed();
-            }
-            else if (name == QLatin1String("enclosure")) {
-                if (xml.attributes().value("type") == QLatin1String("application/x-bittorrent"))
-                    article[Article::KeyTorrentURL] = xml.attributes().value(QLatin1String("url")).toString();
-                else if (xml.attributes().value("type").isEmpty())
-                    altTorrentUrl = xml.attributes().value(QLatin1String("url")).toString();
-            }
-            else if (name == QLatin1String("link")) {
-                const QString text {xml.readElementText().trimmed()};
-                if (text.startsWith(QLatin1String("magnet:"), Qt::CaseInsensitive))
-                    article[Article::KeyTorrentURL] = text; // magnet link instead of a news URL
-                else
-                    article[Article::KeyLink] = text;
-            }
-            else if (name == QLatin1String("description")) {
-                article[Article::KeyDescription] = xml.readElementText(QXmlStreamReader::IncludeChildElements);
-            }
-            else if (name == QLatin1String("pubDate")) {
-                article[Article::KeyDate] = parseDate(xml.readElementText().trimmed());
-            }
-            else if (name == QLatin1String("author")) {
-                article[Article::KeyAuthor] = xml.readElementText().trimmed();
-            }
-            else if (name == QLatin1String("guid")) {
-                article[Article::KeyId] = xml.readElementText().trimmed();
-            }
-            else {
-                article[name] = xml.readElementText(QXmlStreamReader::IncludeChildElements);
-            }
-        }
+    if (m_isBuffering) {
+        m_isBuffering = false;
+        m_xml.addData(m_bufferedData);
+        m_bufferedData.clear();
     }
 
-    if (article[Article::KeyTorrentURL].toString().isEmpty())
-        article[Article::KeyTorrentURL] = altTorrentUrl;
+    // Whatever is left unparsed now is incomplete (i.e. premature end of document)
+    if (m_isParsing) {
+        parseAvailableData();
+        if (m_isParsing)
+            endParsing();
+    }
 
-    addArticle(article);
+    if (m_result.error.isEmpty()) {
+        m_dataBlockHashes = m_receivedBlockHashes;
+        m_dataSize = m_receivedSize;
+    }
+
+    finish();
 }
 
-void Parser::parseRSSChannel(QXmlStreamReader &xml)
+void Parser::hashReceivedData(const QByteArray &data)
 {
-    while (!xml.atEnd()) {
-        xml.readNext();
-
-        if (xml.isStartElement()) {
-            if (xml.name() == QLatin1String("title")) {
-                m_result.title = xml.readElementText();
-            }
-            else if (xml.name() == QLatin1String("lastBuildDate")) {
-                const QString lastBuildDate = xml.readElementText();
-                if (!lastBuildDate.isEmpty()) {
-                    if (m_result.lastBuildDate == lastBuildDate) {
-                        qDebug() << "The RSS feed has not changed since last time, aborting parsing.";
-                        return;
-                    }
-                    m_result.lastBuildDate = lastBuildDate;
-                }
-            }
-            else if (xml.name() == QLatin1String("item")) {
-                parseRssArticle(xml);
-            }
+    int pos = 0;
+    while (pos < data.size()) {
+        const int blockRemaining = static_cast<int>(DATA_BLOCK_SIZE - (m_receivedSize % DATA_BLOCK_SIZE));
+        const int length = std::min(blockRemaining, (data.size() - pos));
+        m_blockHash.addData(data.constData() + pos, length);
+        pos += length;
+        m_receivedSize += length;
+
+        if ((m_receivedSize % DATA_BLOCK_SIZE) == 0) {
+            m_receivedBlockHashes.append(m_blockHash.result());
+            m_blockHash.reset();
         }
     }
 }
 
-void Parser::parseAtomArticle(QXmlStreamReader &xml)
+void Parser::endParsing()
+{
+    m_isParsing = false;
+
+    if (m_channelDepth == 0) {
+        m_result.error = tr("Invalid RSS feed.");
+    }
+    else if (m_xml.hasError()) {
+        m_result.error = tr("%1 (line: %2, column: %3, offset: %4).")
+                .arg(m_xml.errorString()).arg(m_xml.lineNumber())
+                .arg(m_xml.columnNumber()).arg(m_xml.characterOffset());
+    }
+}
+
+void Parser::stopParsing()
 {
-    QVariantHash article;
-    bool doubleContent = false;
+    endParsing();
+    finish();
+}
 
-    while (!xml.atEnd()) {
-        xml.readNext();
-        const QString name(xml.name().toString());
+void Parser::finish()
+{
+    m_isFinished = true;
+    // Abandoned parsing never gets here, so its feed is parsed again next time
+    if (m_result.error.isEmpty() && !m_result.lastBuildDate.isEmpty())
+        m_lastBuildDate = m_result.lastBuildDate;
+    m_result.articles = m_parsedArticles;
+    emit finished(m_parsingID, m_result);
+
+    m_result.articles.clear(); // clear articles only
+    m_parsedArticles.clear();
+    m_articleIDs.clear();
+    m_knownArticleIDs.clear();
+    m_xml.clear();
+}
 
-        if (xml.isEndElement() && (name == QLatin1String("entry")))
+// read and create items from a rss document
+void Parser::parseAvailableData()
+{
+    while (m_isParsing) {
+        switch (m_xml.readNext()) {
+        case QXmlStreamReader::StartElement:
+            ++m_depth;
+            processStartElement();
+            break;
+        case QXmlStreamReader::EndElement:
+            processEndElement();
+            --m_depth;
+            break;
+        case QXmlStreamReader::Characters:
+        case QXmlStreamReader::EntityReference:
+            if (m_textDepth > 0)
+                m_text += m_xml.text();
+            break;
+        case QXmlStreamReader::EndDocument:
+            endParsing();
             break;
+        case QXmlStreamReader::Invalid:
+            // wait for more data unless it is a real error
+            if (m_xml.error() != QXmlStreamReader::PrematureEndOfDocumentError)
+                endParsing();
+            return;
+        default:
+            break;
+        }
+    }
+}
 
-        if (xml.isStartElement()) {
-            if (name == QLatin1String("title")) {
-                article[Article::KeyTitle] = xml.readElementText().trimmed();
-            }
-            else if (name == QLatin1String("link")) {
-                const QString link = (xml.attributes().isEmpty()
-                                ? xml.readElementText().trimmed()
-                                : xml.attributes().value(QLatin1String("href")).toString());
-
-                if (link.startsWith(QLatin1String("magnet:"), Qt::CaseInsensitive))
-                    article[Article::KeyTorrentURL] = link; // magnet link instead of a news URL
-                else
-                    // Atom feeds can have relative links, work around this and
-                    // take the stress of figuring article full URI from UI
-                    // Assemble full URI
-                    article[Article::KeyLink] = (m_baseUrl.isEmpty() ? link : m_baseUrl + link);
+void Parser::processStartElement()
+{
+    if (m_textDepth > 0)
+        return; // text of the whole subtree is collected
 
-            }
-            else if ((name == QLatin1String("summary")) || (name == QLatin1String("content"))) {
-                if (doubleContent) { // Duplicate content -> ignore
-                    xml.skipCurrentElement();
-                    continue;
-                }
+    const QString name = m_xml.name().toString();
 
-                // Try to also parse broken articles, which don't use html '&' escapes
-                // Actually works great for non-broken content too
-                const QString feedText = xml.readElementText(QXmlStreamReader::IncludeChildElements).trimmed();
-                if (!feedText.isEmpty()) {
-                    article[Article::KeyDescription] = feedText;
-                    doubleContent = true;
-                }
+    if (m_channelDepth == 0) {
+        if (m_depth == 1) {
+            if (name == QLatin1String("rss")) {
+                // channel is expected to be the child of root element
+                m_format = FeedFormat::RSS;
             }
-            else if (name == QLatin1String("updated")) {
-                // ATOM uses standard compliant date, don't do fancy stuff
-                const QDateTime articleDate = QDateTime::fromString(xml.readElementText().trimmed(), Qt::ISODate);
-                article[Article::KeyDate] = (articleDate.isValid() ? articleDate : QDateTime::currentDateTime());
-            }
-            else if (name == QLatin1String("author")) {
-                while (xml.readNextStartElement()) {
-                    if (xml.name() == QLatin1String("name"))
-                        article[Article::KeyAuthor] = xml.readElementText().trimmed();
-                    else
-                        xml.skipCurrentElement();
-                }
-            }
-            else if (name == QLatin1String("id")) {
-                article[Article::KeyId] = xml.readElementText().trimmed();
+            else if (name == QLatin1String("feed")) { // Atom feed
+                m_format = FeedFormat::Atom;
+                m_channelDepth = m_depth;
+                m_baseUrl = m_xml.attributes().value("xml:base").toString();
             }
             else {
-                article[name] = xml.readElementText(QXmlStreamReader::IncludeChildElements);
+                qDebug() << "Skip root item: " << name;
             }
         }
+        else if ((m_depth == 2) && (m_format == FeedFormat::RSS) && (name == QLatin1String("channel"))) {
+            m_channelDepth = m_depth;
+        }
+        return;
     }
 
-    addArticle(article);
+    if (m_articleDepth > 0) {
+        if (m_depth == (m_articleDepth + 1)) {
+            processArticleElement(name);
+        }
+        else if ((m_authorDepth > 0) && (m_depth == (m_authorDepth + 1))) {
+            if (name == QLatin1String("name")) {
+                m_textDepth = m_depth;
+                m_textElementName = name;
+            }
+        }
+        return;
+    }
+
+    const bool isRSS = (m_format == FeedFormat::RSS);
+    if ((name == QLatin1String("title"))
+            || (name == (isRSS ? QLatin1String("lastBuildDate") : QLatin1String("updated")))) {
+        m_textDepth = m_depth;
+        m_textElementName = name;
+    }
+    else if (name == (isRSS ? QLatin1String("item") : QLatin1String("entry"))) {
+        m_articleDepth = m_depth;
+        m_article.clear();
+        m_altTorrentUrl.clear();
+        m_doubleContent = false;
+    }
 }
 
-void Parser::parseAtomChannel(QXmlStreamReader &xml)
+void Parser::processArticleElement(const QString &name)
 {
-    m_baseUrl = xml.attributes().value("xml:base").toString();
+    if (m_format == FeedFormat::RSS) {
+        if (name == QLatin1String("enclosure")) {
+            if (m_xml.attributes().value("type") == QLatin1String("application/x-bittorrent"))
+                m_article[Article::KeyTorrentURL] = m_xml.attributes().value(QLatin1String("url")).toString();
+            else if (m_xml.attributes().value("type").isEmpty())
+                m_altTorrentUrl = m_xml.attributes().value(QLatin1String("url")).toString();
+            return;
+        }
+    }
+    else {
+        if ((name == QLatin1String("link")) && !m_xml.attributes().isEmpty()) {
+            processElementText(name, m_xml.attributes().value(QLatin1String("href")).toString());
+            return;
+        }
+        if (name == QLatin1String("author")) {
+            m_authorDepth = m_depth;
+            return;
+        }
+    }
 
-    while (!xml.atEnd()) {
-        xml.readNext();
+    m_textDepth = m_depth;
+    m_textElementName = name;
+}
 
-        if (xml.isStartElement()) {
-            if (xml.name() == QLatin1String("title")) {
-                m_result.title = xml.readElementText();
-            }
-            else if (xml.name() == QLatin1String("updated")) {
-                const QString lastBuildDate = xml.readElementText();
-                if (!lastBuildDate.isEmpty()) {
-                    if (m_result.lastBuildDate == lastBuildDate) {
-                        qDebug() << "The RSS feed has not changed since last time, aborting parsing.";
-                        return;
-                    }
-                    m_result.lastBuildDate = lastBuildDate;
-                }
+void Parser::processEndElement()
+{
+    if (m_textDepth == m_depth) {
+        m_textDepth = 0;
+        processElementText(m_textElementName, m_text);
+        m_text.clear();
+    }
+    else if (m_authorDepth == m_depth) {
+        m_authorDepth = 0;
+    }
+    else if (m_articleDepth == m_depth) {
+        m_articleDepth = 0;
+
+        if ((m_format == FeedFormat::RSS) && m_article[Article::KeyTorrentURL].toString().isEmpty())
+            m_article[Article::KeyTorrentURL] = m_altTorrentUrl;
+
+        addArticle(m_article);
+        m_article.clear();
+    }
+    else if (m_channelDepth == m_depth) {
+        endParsing();
+    }
+}
+
+void Parser::processElementText(const QString &name, const QString &text)
+{
+    if (m_articleDepth == 0) {
+        // channel info
+        if (name == QLatin1String("title")) {
+            m_result.title = text;
+        }
+        else if (!text.isEmpty()) { // last build date
+            m_result.lastBuildDate = text;
+            if (m_lastBuildDate == text) {
+                qDebug() << "The RSS feed has not changed since last time, aborting parsing.";
+                stopParsing();
+                return;
             }
-            else if (xml.name() == QLatin1String("entry")) {
-                parseAtomArticle(xml);
+        }
+        return;
+    }
+
+    if (m_authorDepth > 0) {
+        m_article[Article::KeyAuthor] = text.trimmed();
+        return;
+    }
+
+    if (name == QLatin1String("title")) {
+        m_article[Article::KeyTitle] = text.trimmed();
+    }
+    else if (name == QLatin1String("author")) {
+        m_article[Article::KeyAuthor] = text.trimmed();
+    }
+    else if (m_format == FeedFormat::RSS) {
+        if (name == QLatin1String("link")) {
+            const QString link = text.trimmed();
+            if (link.startsWith(QLatin1String("magnet:"), Qt::CaseInsensitive))
+                m_article[Article::KeyTorrentURL] = link; // magnet link instead of a news URL
+            else
+                m_article[Article::KeyLink] = link;
+        }
+        else if (name == QLatin1String("description")) {
+            m_article[Article::KeyDescription] = text;
+        }
+        else if (name == QLatin1String("pubDate")) {
+            m_article[Article::KeyDate] = parseDate(text.trimmed());
+        }
+        else if (name == QLatin1String("guid")) {
+            m_article[Article::KeyId] = text.trimmed();
+        }
+        else {
+            m_article[name] = text;
+        }
+    }
+    else {
+        if (name == QLatin1String("link")) {
+            const QString link = text.trimmed();
+            if (link.startsWith(QLatin1String("magnet:"), Qt::CaseInsensitive))
+                m_article[Article::KeyTorrentURL] = link; // magnet link instead of a news URL
+            else
+                // Atom feeds can have relative links, work around this and
+                // take the stress of figuring article full URI from UI
+                // Assemble full URI
+                m_article[Article::KeyLink] = (m_baseUrl.isEmpty() ? link : m_baseUrl + link);
+        }
+        else if ((name == QLatin1String("summary")) || (name == QLatin1String("content"))) {
+            // Duplicate content is ignored
+            // Try to also parse broken articles, which don't use html '&' escapes
+            // Actually works great for non-broken content too
+            const QString feedText = text.trimmed();
+            if (!m_doubleContent && !feedText.isEmpty()) {
+                m_article[Article::KeyDescription] = feedText;
+                m_doubleContent = true;
             }
         }
+        else if (name == QLatin1String("updated")) {
+            // ATOM uses standard compliant date, don't do fancy stuff
+            const QDateTime articleDate = QDateTime::fromString(text.trimmed(), Qt::ISODate);
+            m_article[Article::KeyDate] = (articleDate.isValid() ? articleDate : QDateTime::currentDateTime());
+        }
+        else if (name == QLatin1String("id")) {
+            m_article[Article::KeyId] = text.trimmed();
+        }
+        else {
+            m_article[name] = text;
+        }
     }
 }
 
@@ -791,5 +980,23 @@ void Parser::addArticle(QVariantHash article)
     }
 
     m_articleIDs.insert(localId.toString());
-    m_result.articles.prepend(article);
+    m_parsedArticles.prepend(article);
+
+    // Skipping the rest of the feed is only safe if it lists articles from newest to oldest
+    const QDateTime articleDate = article.value(Article::KeyDate).toDateTime();
+    if (!articleDate.isValid() || (m_lastArticleDate.isValid() && (articleDate > m_lastArticleDate)))
+        m_isNewestFirst = false;
+    m_lastArticleDate = articleDate;
+
+    if (!m_knownArticleIDs.contains(localId.toString())) {
+        m_knownArticlesInRow = 0;
+        return;
+    }
+
+    ++m_knownArticlesInRow;
+    if (m_isNewestFirst && (m_articleIDs.size() > 1)
+            && (m_knownArticlesInRow >= std::min(KNOWN_ARTICLES_TO_STOP, m_knownArticleIDs.size()))) {
+        qDebug() << "The rest of the RSS feed is already known, aborting parsing.";
+        stopParsing();
+    }
 }
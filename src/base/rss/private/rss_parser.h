@@ -29,13 +29,16 @@
 
 #pragma once
 
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QList>
+#include <QVector>
 #include <QObject>
 #include <QSet>
 #include <QString>
+#include <QStringList>
 #include <QVariantHash>
-
-class QXmlStreamReader;
+#include <QXmlStreamReader>
 
 namespace RSS
 {
@@ -49,28 +52,81 @@ namespace RSS
             QList<QVariantHash> articles;
         };
 
+        // Parses feed data incrementally, as it is being downloaded.
+        // Parsed articles are reported in batches (one per chunk of data) and the rest
+        // (if any) along with the feed info when parsing is finished. Parsing is finished
+        // early when the feed wasn't changed or the rest of its articles is already known.
+        // Data that is the same as the last successfully parsed one isn't parsed at all.
         class Parser : public QObject
         {
             Q_OBJECT
 
         public:
             explicit Parser(QString lastBuildDate);
-            void parse(const QByteArray &feedData);
+
+            void startParsing(int parsingID, const QStringList &knownArticleIDs);
+            void addData(const QByteArray &data);
+            void finishParsing();
 
         signals:
-            void finished(const RSS::Private::ParsingResult &result);
+            void articlesParsed(int parsingID, const QList<QVariantHash> &articles);
+            void finished(int parsingID, const RSS::Private::ParsingResult &result);
 
         private:
-            Q_INVOKABLE void parse_impl(const QByteArray &feedData);
-            void parseRssArticle(QXmlStreamReader &xml);
-            void parseRSSChannel(QXmlStreamReader &xml);
-            void parseAtomArticle(QXmlStreamReader &xml);
-            void parseAtomChannel(QXmlStreamReader &xml);
+            enum class FeedFormat
+            {
+                Unknown,
+                RSS,
+                Atom
+            };
+
+            Q_INVOKABLE void startParsing_impl(int parsingID, const QStringList &knownArticleIDs);
+            Q_INVOKABLE void addData_impl(const QByteArray &data);
+            Q_INVOKABLE void finishParsing_impl();
+            void hashReceivedData(const QByteArray &data);
+            void parseAvailableData();
+            void processStartElement();
+            void processEndElement();
+            void processElementText(const QString &name, const QString &text);
+            void processArticleElement(const QString &name);
             void addArticle(QVariantHash article);
+            void endParsing();
+            void stopParsing();
+            void finish();
 
+            QXmlStreamReader m_xml;
+            int m_parsingID = 0;
+            bool m_isFinished = true;
+            bool m_isParsing = false;
+            FeedFormat m_format = FeedFormat::Unknown;
+            int m_depth = 0;
+            int m_channelDepth = 0;
+            int m_articleDepth = 0;
+            int m_authorDepth = 0;
+            int m_textDepth = 0;
+            QString m_textElementName;
+            QString m_text;
+            QVariantHash m_article;
+            QString m_altTorrentUrl;
+            bool m_doubleContent = false;
             QString m_baseUrl;
             ParsingResult m_result;
+            // Build date of the last completely processed feed
+            QString m_lastBuildDate;
+            QList<QVariantHash> m_parsedArticles;
             QSet<QString> m_articleIDs;
+            QSet<QString> m_knownArticleIDs;
+            int m_knownArticlesInRow = 0;
+            bool m_isNewestFirst = true;
+            QDateTime m_lastArticleDate;
+
+            QVector<QByteArray> m_dataBlockHashes;
+            qint64 m_dataSize = 0;
+            QVector<QByteArray> m_receivedBlockHashes;
+            qint64 m_receivedSize = 0;
+            QCryptographicHash m_blockHash {QCryptographicHash::Md5};
+            QByteArray m_bufferedData;
+            bool m_isBuffering = false;
         };
     }
 }
@@ -48,6 +48,19 @@ namespace
 
         return varHash;
     }
+
+    bool isKnownKey(const QString &key)
+    {
+        return ((key == Article::KeyId) || (key == Article::KeyDate) || (key == Article::KeyTitle)
+                || (key == Article::KeyAuthor) || (key == Article::KeyDescription) || (key == Article::KeyTorrentURL)
+                || (key == Article::KeyLink) || (key == Article::KeyIsRead));
+    }
+
+    void insertNonEmpty(QVariantHash &varHash, const QString &key, const QString &value)
+    {
+        if (!value.isEmpty())
+            varHash[key] = value;
+    }
 }
 
 const QString Article::KeyId(QStringLiteral("id"));
@@ -60,18 +73,21 @@ const QString Article::KeyLink(QStringLiteral("link"));
 const QString Article::KeyIsRead(QStringLiteral("isRead"));
 
 Article::Article(Feed *feed, const QVariantHash &varHash)
-    : QObject(feed)
-    , m_feed(feed)
+    : m_feed(feed)
     , m_guid(varHash.value(KeyId).toString())
     , m_date(varHash.value(KeyDate).toDateTime())
     , m_title(varHash.value(KeyTitle).toString())
-    , m_author(varHash.value(KeyAuthor).toString())
+    , m_author(feed->internString(varHash.value(KeyAuthor).toString()))
     , m_description(varHash.value(KeyDescription).toString())
     , m_torrentURL(varHash.value(KeyTorrentURL).toString())
     , m_link(varHash.value(KeyLink).toString())
     , m_isRead(varHash.value(KeyIsRead, false).toBool())
-    , m_data(varHash)
 {
+    for (auto it = varHash.cbegin(); it != varHash.cend(); ++it) {
+        if (!isKnownKey(it.key()))
+            m_extraData.append({feed->internString(it.key()), it.value()});
+    }
+    m_extraData.squeeze();
 }
 
 Article::Article(Feed *feed, const QJsonObject &jsonObj)
@@ -121,21 +137,35 @@ bool Article::isRead() const
 
 QVariantHash Article::data() const
 {
-    return m_data;
+    // Article data is materialized on demand only
+    QVariantHash varHash;
+    varHash.reserve(m_extraData.size() + 8);
+    for (const auto &field : m_extraData)
+        varHash.insert(field.first, field.second);
+
+    varHash[KeyId] = m_guid;
+    varHash[KeyDate] = m_date;
+    insertNonEmpty(varHash, KeyTitle, m_title);
+    insertNonEmpty(varHash, KeyAuthor, m_author);
+    insertNonEmpty(varHash, KeyDescription, m_description);
+    insertNonEmpty(varHash, KeyTorrentURL, m_torrentURL);
+    insertNonEmpty(varHash, KeyLink, m_link);
+    varHash[KeyIsRead] = m_isRead;
+
+    return varHash;
 }
 
 void Article::markAsRead()
 {
     if (!m_isRead) {
         m_isRead = true;
-        m_data[KeyIsRead] = m_isRead;
-        emit read(this);
+        m_feed->handleArticleRead(this);
     }
 }
 
 QJsonObject Article::toJsonObject() const
 {
-    auto jsonObj = QJsonObject::fromVariantHash(m_data);
+    auto jsonObj = QJsonObject::fromVariantHash(data());
     // JSON object doesn't support DateTime so we need to convert it
     jsonObj[KeyDate] = m_date.toString(Qt::RFC2822Date);
 
@@ -31,17 +31,19 @@
 #pragma once
 
 #include <QDateTime>
-#include <QObject>
+#include <QPair>
 #include <QString>
 #include <QVariantHash>
+#include <QVector>
 
 namespace RSS
 {
     class Feed;
 
-    class Article : public QObject
+    // Article is kept as a plain object since there can be a lot of them.
+    // Its owner feed is notified about article changes directly.
+    class Article
     {
-        Q_OBJECT
         Q_DISABLE_COPY(Article)
 
         friend class Feed;
@@ -76,9 +78,6 @@ namespace RSS
 
         static bool articleDateRecentThan(const Article *article, const QDateTime &date);
 
-    signals:
-        void read(Article *article = nullptr);
-
     private:
         Feed *m_feed = nullptr;
         QString m_guid;
@@ -88,7 +87,8 @@ namespace RSS
         QString m_description;
         QString m_torrentURL;
         QString m_link;
+        // Fields which have no dedicated members
+        QVector<QPair<QString, QVariant>> m_extraData;
         bool m_isRead = false;
-        QVariantHash m_data;
     };
 }
@@ -28,8 +28,11 @@
 
 #include "rss_autodownloader.h"
 
+#include <algorithm>
+
 #include <QDataStream>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonValue>
@@ -61,6 +64,9 @@ struct ProcessingJob
     QVariantHash articleData;
 };
 
+// Time budget (ms) of a single processing batch, after which the event loop gets control back
+const int PROCESSING_TIME_SLICE = 5;
+
 const QString ConfFolderName(QStringLiteral("rss"));
 const QString RulesFileName(QStringLiteral("download_rules.json"));
 
@@ -201,6 +207,7 @@ bool AutoDownloader::renameRule(const QString &ruleName, const QString &newRuleN
     if (hasRule(newRuleName)) return false;
 
     m_rules.insert(newRuleName, m_rules.take(ruleName));
+    m_ruleIndexDirty = true;
     m_dirty = true;
     store();
     emit ruleRenamed(newRuleName, ruleName);
@@ -212,6 +219,7 @@ void AutoDownloader::removeRule(const QString &ruleName)
     if (m_rules.contains(ruleName)) {
         emit ruleAboutToBeRemoved(ruleName);
         m_rules.remove(ruleName);
+        m_ruleIndexDirty = true;
         m_dirty = true;
         store();
     }
@@ -321,13 +329,37 @@ void AutoDownloader::setDownloadRepacks(const bool downloadRepacks)
     SettingsStorage::instance()->storeValue(SettingsKey_DownloadRepacks, downloadRepacks);
 }
 
+int AutoDownloader::processingQueueSize() const
+{
+    return m_processingQueue.size();
+}
+
+qreal AutoDownloader::processingThroughput() const
+{
+    return m_processingThroughput;
+}
+
 void AutoDownloader::process()
 {
     if (m_processingQueue.isEmpty()) return; // processing was disabled
 
-    processJob(m_processingQueue.takeFirst());
+    // Process as many jobs as fit in the time slice so the UI stays responsive
+    QElapsedTimer elapsedTimer;
+    elapsedTimer.start();
+
+    int processedCount = 0;
+    do {
+        processJob(m_processingQueue.takeFirst());
+        ++processedCount;
+    } while (!m_processingQueue.isEmpty() && !elapsedTimer.hasExpired(PROCESSING_TIME_SLICE));
+
+    const qreal batchThroughput = processedCount * 1e9 / std::max<qint64>(elapsedTimer.nsecsElapsed(), 1);
+    m_processingThroughput = (m_processingThroughput > 0)
+        ? ((0.75 * m_processingThroughput) + (0.25 * batchThroughput))
+        : batchThroughput;
+
     if (!m_processingQueue.isEmpty())
-        // Schedule to process the next torrent (if any)
+        // Schedule to process the next batch (if any)
         m_processingTimer->start();
 }
 
@@ -356,6 +388,7 @@ void AutoDownloader::handleNewArticle(const Article *article)
 void AutoDownloader::setRule_impl(const AutoDownloadRule &rule)
 {
     m_rules.insert(rule.name(), rule);
+    m_ruleIndexDirty = true;
 }
 
 void AutoDownloader::addJobForArticle(const Article *article)
@@ -373,8 +406,17 @@ void AutoDownloader::addJobForArticle(const Article *article)
 
 void AutoDownloader::processJob(const QSharedPointer<ProcessingJob> &job)
 {
-    for (AutoDownloadRule &rule : m_rules) {
-        if (!rule.isEnabled()) continue;
+    if (m_ruleIndexDirty)
+        rebuildRuleIndex();
+
+    // Only rules whose keywords occur in the title (or which have no keywords) can match it
+    QVector<bool> candidates = m_unfilteredRules;
+    m_ruleKeywordMatcher.match(job->articleData.value(Article::KeyTitle).toString(), candidates);
+
+    for (int i = 0; i < m_indexedRules.size(); ++i) {
+        if (!candidates[i]) continue;
+
+        AutoDownloadRule &rule = m_rules[m_indexedRules[i]];
         if (!rule.feedURLs().contains(job->feedURL)) continue;
         if (!rule.accepts(job->articleData)) continue;
 
@@ -389,7 +431,7 @@ void AutoDownloader::processJob(const QSharedPointer<ProcessingJob> &job)
         if (!rule.savePath().isEmpty())
             params.useAutoTMM = TriStateBool::False;
         const auto torrentURL = job->articleData.value(Article::KeyTorrentURL).toString();
-        BitTorrent::Session::instance()->addTorrent(torrentURL, params);
+        BitTorrent::Session::instance()->addTorrents(QStringList {torrentURL}, params);
 
         if (BitTorrent::MagnetUri(torrentURL).isValid()) {
             if (Feed *feed = Session::instance()->feedByURL(job->feedURL)) {
@@ -407,6 +449,29 @@ void AutoDownloader::processJob(const QSharedPointer<ProcessingJob> &job)
     }
 }
 
+void AutoDownloader::rebuildRuleIndex()
+{
+    m_indexedRules.clear();
+    m_unfilteredRules.clear();
+    m_ruleKeywordMatcher = Private::KeywordMatcher();
+
+    for (auto it = m_rules.cbegin(); it != m_rules.cend(); ++it) {
+        const AutoDownloadRule &rule = it.value();
+        if (!rule.isEnabled()) continue;
+
+        const int ruleIndex = m_indexedRules.size();
+        m_indexedRules.append(it.key());
+
+        const QStringList keywords = rule.requiredKeywords();
+        m_unfilteredRules.append(keywords.isEmpty());
+        for (const QString &keyword : keywords)
+            m_ruleKeywordMatcher.addKeyword(keyword, ruleIndex);
+    }
+
+    m_ruleKeywordMatcher.build();
+    m_ruleIndexDirty = false;
+}
+
 void AutoDownloader::load()
 {
     QFile rulesFile(m_fileStorage->storageDir().absoluteFilePath(RulesFileName));
@@ -474,9 +539,15 @@ void AutoDownloader::resetProcessingQueue()
     m_processingQueue.clear();
     if (!m_processingEnabled) return;
 
-    for (Article *article : asConst(Session::instance()->rootFolder()->articles())) {
-        if (!article->isRead() && !article->torrentUrl().isEmpty())
-            addJobForArticle(article);
+    for (Feed *feed : asConst(Session::instance()->feeds())) {
+        // feeds without unread articles aren't loaded just to be checked
+        if (feed->unreadCount() == 0)
+            continue;
+
+        for (Article *article : asConst(feed->articles())) {
+            if (!article->isRead() && !article->torrentUrl().isEmpty())
+                addJobForArticle(article);
+        }
     }
 }
 
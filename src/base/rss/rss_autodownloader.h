@@ -37,6 +37,10 @@
 #include <QPointer>
 #include <QRegularExpression>
 #include <QSharedPointer>
+#include <QStringList>
+#include <QVector>
+
+#include "private/rss_keywordmatcher.h"
 
 class QThread;
 class QTimer;
@@ -89,6 +93,10 @@ namespace RSS
         bool downloadRepacks() const;
         void setDownloadRepacks(bool downloadRepacks);
 
+        int processingQueueSize() const;
+        // Articles matched per second of processing time (smoothed over recent batches)
+        qreal processingThroughput() const;
+
         bool hasRule(const QString &ruleName) const;
         AutoDownloadRule ruleByName(const QString &ruleName) const;
         QList<AutoDownloadRule> rules() const;
@@ -120,6 +128,7 @@ namespace RSS
         void startProcessing();
         void addJobForArticle(const Article *article);
         void processJob(const QSharedPointer<ProcessingJob> &job);
+        void rebuildRuleIndex();
         void load();
         void loadRules(const QByteArray &data);
         void loadRulesLegacy();
@@ -137,7 +146,13 @@ namespace RSS
         QThread *m_ioThread;
         AsyncFileStorage *m_fileStorage;
         QHash<QString, AutoDownloadRule> m_rules;
+        // Enabled rules in matching order, prefiltered by title keywords
+        QStringList m_indexedRules;
+        QVector<bool> m_unfilteredRules;
+        Private::KeywordMatcher m_ruleKeywordMatcher;
+        bool m_ruleIndexDirty = true;
         QList<QSharedPointer<ProcessingJob>> m_processingQueue;
+        qreal m_processingThroughput = 0;
         QHash<QString, QSharedPointer<ProcessingJob>> m_waitingJobs;
         bool m_dirty = false;
         QBasicTimer m_savingTimer;
@@ -45,6 +45,7 @@
 #include "../tristatebool.h"
 #include "../utils/fs.h"
 #include "../utils/string.h"
+#include "private/rss_keywordmatcher.h"
 #include "rss_article.h"
 #include "rss_autodownloader.h"
 #include "rss_feed.h"
@@ -88,6 +89,129 @@ namespace
         default: return 0; // default
         }
     }
+
+    using RSS::Private::KeywordMatcher;
+
+    // Longest run of plain characters in a wildcard, i.e. the part
+    // any matching title must contain verbatim
+    QString wildcardKeyword(const QString &wildcard)
+    {
+        QString keyword;
+        QString current;
+        for (int i = 0; i < wildcard.size(); ++i) {
+            const QChar c = wildcard[i];
+            if (KeywordMatcher::isKeywordChar(c)) {
+                current += c;
+                continue;
+            }
+
+            if (current.size() > keyword.size())
+                keyword = current;
+            current.clear();
+
+            if (c == '[') {
+                // skip the whole set the same way Utils::String::wildcardToRegex() does,
+                // a ']' right after the opening bracket (or negation) is a member
+                int j = i + 1;
+                if ((j < wildcard.size()) && ((wildcard[j] == '^') || (wildcard[j] == '!')))
+                    ++j;
+                if ((j < wildcard.size()) && (wildcard[j] == ']'))
+                    ++j;
+                while ((j < wildcard.size()) && (wildcard[j] != ']'))
+                    ++j;
+                i = j;
+            }
+        }
+
+        return (current.size() > keyword.size()) ? current : keyword;
+    }
+
+    // Longest run of plain characters that any match of the regular expression must
+    // contain verbatim. Only top level sequences are considered and patterns that are
+    // not trivially analyzable (alternation, inline options, numeric escapes etc.) yield nothing.
+    QString regexKeyword(const QString &pattern)
+    {
+        if (pattern.contains('|') || pattern.contains(QLatin1String("(?")))
+            return {};
+
+        QString keyword;
+        QString current;
+        const auto flush = [&keyword, &current]()
+        {
+            if (current.size() > keyword.size())
+                keyword = current;
+            current.clear();
+        };
+
+        int depth = 0;
+        for (int i = 0; i < pattern.size(); ++i) {
+            const QChar c = pattern[i];
+
+            if (c == '\\') {
+                flush();
+                if (++i >= pattern.size())
+                    break;
+                // escaped punctuation and single character classes/assertions
+                // are fine, anything else may hide characters or references
+                const QChar escaped = pattern[i];
+                if (KeywordMatcher::isKeywordChar(escaped) && !QString("dDsSwWbBAzZhHvVR").contains(escaped))
+                    return {};
+                continue;
+            }
+
+            if (c == '[') {
+                flush();
+                // skip the whole set, a ']' right after the opening bracket is a member
+                int j = i + 1;
+                if ((j < pattern.size()) && (pattern[j] == '^'))
+                    ++j;
+                if ((j < pattern.size()) && (pattern[j] == ']'))
+                    ++j;
+                for (; (j < pattern.size()) && (pattern[j] != ']'); ++j) {
+                    if (pattern[j] == '\\')
+                        ++j;
+                }
+                i = j;
+                continue;
+            }
+
+            if (c == '{') {
+                flush();
+                while ((i < pattern.size()) && (pattern[i] != '}'))
+                    ++i;
+                continue;
+            }
+
+            if (c == '(') {
+                flush();
+                ++depth;
+                continue;
+            }
+
+            if (c == ')') {
+                flush();
+                --depth;
+                continue;
+            }
+
+            if ((depth == 0) && KeywordMatcher::isKeywordChar(c)) {
+                const QChar nextChar = (i + 1 < pattern.size()) ? pattern[i + 1] : QChar();
+                if ((nextChar == '?') || (nextChar == '*') || (nextChar == '{')) {
+                    // the last character is optional
+                    flush();
+                    continue;
+                }
+
+                current += c;
+                continue;
+            }
+
+            flush();
+        }
+
+        flush();
+        return keyword;
+    }
 }
 
 const QString Str_Name(QStringLiteral("name"));
@@ -375,6 +499,39 @@ bool AutoDownloadRule::matchesSmartEpisodeFilter(const QString &articleTitle) co
     return true;
 }
 
+QStringList AutoDownloadRule::requiredKeywords() const
+{
+    if (m_dataPtr->mustContain.empty())
+        return {};
+
+    const QRegularExpression whitespace {"\\s+"};
+
+    // A title matches if it matches any of expressions, so each of them must provide a keyword
+    QStringList keywords;
+    for (const QString &expression : asConst(m_dataPtr->mustContain)) {
+        QString keyword;
+        if (m_dataPtr->useRegex) {
+            keyword = regexKeyword(expression);
+        }
+        else {
+            // every wildcard token must match, so the longest keyword of them is the most selective
+            for (const QString &wildcard : asConst(expression.split(whitespace, QString::SkipEmptyParts))) {
+                const QString wildcardKw = wildcardKeyword(wildcard);
+                if (wildcardKw.size() > keyword.size())
+                    keyword = wildcardKw;
+            }
+        }
+
+        if (keyword.isEmpty())
+            return {};
+
+        keywords.append(keyword);
+    }
+
+    keywords.removeDuplicates();
+    return keywords;
+}
+
 bool AutoDownloadRule::matches(const QVariantHash &articleData) const
 {
     const QDateTime articleDate {articleData[Article::KeyDate].toDateTime()};
@@ -84,6 +84,10 @@ namespace RSS
         QString assignedCategory() const;
         void setCategory(const QString &category);
 
+        // Keywords at least one of which is contained (case insensitively) in the title
+        // of every article the rule matches. Empty if no such keywords can be derived.
+        QStringList requiredKeywords() const;
+
         bool matches(const QVariantHash &articleData) const;
         bool accepts(const QVariantHash &articleData);
 
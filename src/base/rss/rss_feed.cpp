@@ -33,12 +33,17 @@
 #include <algorithm>
 #include <vector>
 
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonValue>
+#include <QSignalBlocker>
+#include <QtEndian>
 #include <QUrl>
+#include <QVariant>
 
 #include "../asyncfilestorage.h"
 #include "../global.h"
@@ -58,6 +63,64 @@ const QString KEY_ISLOADING(QStringLiteral("isLoading"));
 const QString KEY_HASERROR(QStringLiteral("hasError"));
 const QString KEY_ARTICLES(QStringLiteral("articles"));
 
+namespace
+{
+    // Articles data file consists of a header followed by records of the form
+    // <quint32 size><quint8 type><payload>, so changes can be appended to it
+    // without rewriting the existing data.
+    const QByteArray ARTICLES_FILE_SIGNATURE = QByteArrayLiteral("qBittorrent RSS articles");
+    const quint32 ARTICLES_FILE_VERSION = 1;
+    const QDataStream::Version ARTICLES_FILE_STREAM_VERSION = QDataStream::Qt_5_9;
+    // Data file is rewritten once it contains too many records compared to the number of articles
+    const int MIN_RECORDS_TO_COMPACT = 256;
+    // Summary file allows to postpone loading of the articles until they are really needed
+    const quint32 SUMMARY_FILE_VERSION = 1;
+    // Number of the newest articles used to estimate how often a feed is published
+    const int PUBLISHING_STATS_SIZE = 10;
+
+    enum class RecordType : quint8
+    {
+        AddArticle = 1,
+        MarkArticleRead = 2,
+        MarkAllRead = 3,
+        RemoveArticle = 4,
+        SetHTTPValidators = 5
+    };
+
+    const QString KEY_ETAG(QStringLiteral("eTag"));
+    const QString KEY_LASTMODIFIED(QStringLiteral("lastModified"));
+
+    QString jsonDataFileName(const QUuid &uid)
+    {
+        return QString::fromLatin1(uid.toRfc4122().toHex()) + QLatin1String(".json");
+    }
+
+    QByteArray articlesFileHeader()
+    {
+        QByteArray header;
+        QDataStream out(&header, QIODevice::WriteOnly);
+        out.setVersion(ARTICLES_FILE_STREAM_VERSION);
+        out.writeRawData(ARTICLES_FILE_SIGNATURE.constData(), ARTICLES_FILE_SIGNATURE.size());
+        out << ARTICLES_FILE_VERSION;
+        return header;
+    }
+
+    QByteArray makeRecord(const RecordType type, const QVariant &payload = {})
+    {
+        QByteArray record;
+        QDataStream out(&record, QIODevice::WriteOnly);
+        out.setVersion(ARTICLES_FILE_STREAM_VERSION);
+        out << quint32(0) << static_cast<quint8>(type);
+        if (payload.isValid())
+            out << payload;
+
+        // fill in the record size now that it is known
+        out.device()->seek(0);
+        out << static_cast<quint32>(record.size() - sizeof(quint32));
+        return record;
+    }
+}
+
 using namespace RSS;
 
 Feed::Feed(const QUuid &uid, const QString &url, const QString &path, Session *session)
@@ -66,21 +129,25 @@ Feed::Feed(const QUuid &uid, const QString &url, const QString &path, Session *s
     , m_uid(uid)
     , m_url(url)
 {
-    m_dataFileName = QString::fromLatin1(m_uid.toRfc4122().toHex()) + QLatin1String(".json");
+    m_dataFileName = QString::fromLatin1(m_uid.toRfc4122().toHex()) + QLatin1String(".articles");
+    m_summaryFileName = QString::fromLatin1(m_uid.toRfc4122().toHex()) + QLatin1String(".summary");
 
     // Move to new file naming scheme (since v4.1.2)
     const QString legacyFilename {Utils::Fs::toValidFileSystemName(m_url, false, QLatin1String("_"))
                 + QLatin1String(".json")};
     const QDir storageDir {m_session->dataFileStorage()->storageDir()};
-    if (!QFile::exists(storageDir.absoluteFilePath(m_dataFileName)))
-        QFile::rename(storageDir.absoluteFilePath(legacyFilename), storageDir.absoluteFilePath(m_dataFileName));
+    if (!QFile::exists(storageDir.absoluteFilePath(m_dataFileName))
+            && !QFile::exists(storageDir.absoluteFilePath(jsonDataFileName(m_uid))))
+        QFile::rename(storageDir.absoluteFilePath(legacyFilename), storageDir.absoluteFilePath(jsonDataFileName(m_uid)));
 
     m_parser = new Private::Parser(m_lastBuildDate);
     m_parser->moveToThread(m_session->workingThread());
     connect(this, &Feed::destroyed, m_parser, &Private::Parser::deleteLater);
+    connect(m_parser, &Private::Parser::articlesParsed, this, &Feed::handleArticlesParsed);
     connect(m_parser, &Private::Parser::finished, this, &Feed::handleParsingFinished);
 
     connect(m_session, &Session::maxArticlesPerFeedChanged, this, &Feed::handleMaxArticlesPerFeedChanged);
+    connect(m_session->dataFileStorage(), &AsyncFileStorage::failed, this, &Feed::handleDataFileStorageFailed);
 
     if (m_session->isProcessingEnabled())
         downloadIcon();
@@ -96,26 +163,32 @@ Feed::~Feed()
 {
     emit aboutToBeDestroyed(this);
     Utils::Fs::forceRemove(m_iconPath);
+    qDeleteAll(m_articles);
 }
 
 QList<Article *> Feed::articles() const
 {
+    const_cast<Feed *>(this)->loadArticlesOnDemand();
     return m_articlesByDate;
 }
 
 void Feed::markAsRead()
 {
+    if (m_unreadCount == 0) return;
+
+    loadArticlesOnDemand();
+
     const int oldUnreadCount = m_unreadCount;
     for (Article *article : asConst(m_articles)) {
         if (!article->isRead()) {
-            article->disconnect(this);
-            article->markAsRead();
+            article->m_isRead = true;
             --m_unreadCount;
             emit articleRead(article);
         }
     }
 
     if (m_unreadCount != oldUnreadCount) {
+        appendRecord(makeRecord(RecordType::MarkAllRead));
         m_dirty = true;
         store();
         emit unreadCountChanged(this);
@@ -124,12 +197,27 @@ void Feed::markAsRead()
 
 void Feed::refresh()
 {
-    if (m_downloadHandler)
+    if (m_downloadHandler) {
+        m_downloadHandler->disconnect(this);
         m_downloadHandler->cancel();
+    }
 
     // NOTE: Should we allow manually refreshing for disabled session?
 
-    m_downloadHandler = Net::DownloadManager::instance()->download(m_url);
+    // Feed is parsed while it is being downloaded. Results of previous
+    // parsing (if it is still in progress) are ignored from now on.
+    m_newArticlesCount = 0;
+    m_dummyPubDate = QDateTime::currentDateTime();
+    m_downloadedETag = m_eTag;
+    m_downloadedLastModified = m_lastModified;
+    // Articles aren't loaded just to stop parsing earlier, they are loaded
+    // only if the feed content is really changed
+    m_parser->startParsing(++m_parsingID, (m_isArticlesLoaded ? m_articles.keys() : QStringList()));
+
+    m_downloadHandler = Net::DownloadManager::instance()->download(
+                Net::DownloadRequest(m_url).streaming(true).ifNoneMatch(m_eTag).ifModifiedSince(m_lastModified));
+    connect(m_downloadHandler, &Net::DownloadHandler::validatorsReceived, this, &Feed::handleValidatorsReceived);
+    connect(m_downloadHandler, &Net::DownloadHandler::dataReceived, this, &Feed::handleDataReceived);
     connect(m_downloadHandler, &Net::DownloadHandler::finished, this, &Feed::handleDownloadFinished);
 
     m_isLoading = true;
@@ -168,11 +256,15 @@ int Feed::unreadCount() const
 
 Article *Feed::articleByGUID(const QString &guid) const
 {
+    const_cast<Feed *>(this)->loadArticlesOnDemand();
     return m_articles.value(guid);
 }
 
 void Feed::handleMaxArticlesPerFeedChanged(const int n)
 {
+    if (articlesCount() <= n) return;
+
+    loadArticlesOnDemand();
     while (m_articlesByDate.size() > n)
         removeOldestArticle();
     // We don't need store articles here
@@ -191,6 +283,19 @@ bool Feed::hasError() const
     return m_hasError;
 }
 
+void Feed::handleValidatorsReceived(const QString &eTag, const QString &lastModified)
+{
+    // Validators are updated once the content is successfully processed,
+    // which can happen before the download is finished
+    m_downloadedETag = eTag;
+    m_downloadedLastModified = lastModified;
+}
+
+void Feed::handleDataReceived(const QByteArray &data)
+{
+    m_parser->addData(data);
+}
+
 void Feed::handleDownloadFinished(const Net::DownloadResult &result)
 {
     m_downloadHandler = nullptr; // will be deleted by DownloadManager later
@@ -198,10 +303,20 @@ void Feed::handleDownloadFinished(const Net::DownloadResult &result)
     if (result.status == Net::DownloadStatus::Success) {
         LogMsg(tr("RSS feed at '%1' is successfully downloaded. Starting to parse it.")
                 .arg(result.url));
-        // Parse the download RSS
-        m_parser->parse(result.data);
+        // Parse the rest of downloaded RSS
+        m_parser->finishParsing();
+    }
+    else if (result.status == Net::DownloadStatus::NotModified) {
+        ++m_parsingID; // nothing to parse
+        m_isLoading = false;
+        m_hasError = false;
+
+        LogMsg(tr("RSS feed at '%1' is not modified since last update.").arg(result.url));
+
+        emit stateChanged(this);
     }
     else {
+        ++m_parsingID; // parsing of incomplete data can't be finished
         m_isLoading = false;
         m_hasError = true;
 
@@ -212,8 +327,26 @@ void Feed::handleDownloadFinished(const Net::DownloadResult &result)
     }
 }
 
-void Feed::handleParsingFinished(const RSS::Private::ParsingResult &result)
+void Feed::handleArticlesParsed(const int parsingID, const QList<QVariantHash> &articles)
 {
+    if (parsingID != m_parsingID) return; // outdated
+
+    m_newArticlesCount += updateArticles(articles);
+    storeDeferred();
+}
+
+void Feed::handleParsingFinished(const int parsingID, const RSS::Private::ParsingResult &result)
+{
+    if (parsingID != m_parsingID) return; // outdated
+
+    if (m_downloadHandler) {
+        // Parsing is finished before the feed is completely downloaded
+        // since the rest of it is of no interest
+        m_downloadHandler->disconnect(this);
+        m_downloadHandler->cancel();
+        m_downloadHandler = nullptr;
+    }
+
     m_hasError = !result.error.isEmpty();
 
     if (!result.title.isEmpty() && (title() != result.title)) {
@@ -231,7 +364,15 @@ void Feed::handleParsingFinished(const RSS::Private::ParsingResult &result)
     // successfully parsed by the XML parser. We are still trying to load as many articles
     // as possible until we encounter corrupted data. So we can have some articles here
     // even in case of parsing error.
-    const int newArticlesCount = updateArticles(result.articles);
+    m_newArticlesCount += updateArticles(result.articles);
+
+    if (!m_hasError && ((m_downloadedETag != m_eTag) || (m_downloadedLastModified != m_lastModified))) {
+        m_eTag = m_downloadedETag;
+        m_lastModified = m_downloadedLastModified;
+        appendRecord(makeRecord(RecordType::SetHTTPValidators
+                                , QVariantHash {{KEY_ETAG, m_eTag}, {KEY_LASTMODIFIED, m_lastModified}}));
+        m_dirty = true;
+    }
     store();
 
     if (m_hasError) {
@@ -239,7 +380,7 @@ void Feed::handleParsingFinished(const RSS::Private::ParsingResult &result)
                , Log::WARNING);
     }
     LogMsg(tr("RSS feed at '%1' updated. Added %2 new articles.")
-           .arg(url(), QString::number(newArticlesCount)));
+           .arg(url(), QString::number(m_newArticlesCount)));
 
     m_isLoading = false;
     emit stateChanged(this);
@@ -247,25 +388,325 @@ void Feed::handleParsingFinished(const RSS::Private::ParsingResult &result)
 
 void Feed::load()
 {
-    QFile file(m_session->dataFileStorage()->storageDir().absoluteFilePath(m_dataFileName));
+    const QDir storageDir {m_session->dataFileStorage()->storageDir()};
+    QFile file(storageDir.absoluteFilePath(m_dataFileName));
+    QFile jsonFile(storageDir.absoluteFilePath(jsonDataFileName(m_uid)));
 
-    if (!file.exists()) {
-        loadArticlesLegacy();
-        m_dirty = true;
-        store(); // convert to new format
-    }
-    else if (file.open(QFile::ReadOnly)) {
-        loadArticles(file.readAll());
+    if (file.exists()) {
+        // Articles are loaded on first access if the summary matches the data file
+        if (loadSummary(file.size()))
+            return;
+
+        if (!file.open(QFile::ReadOnly)) {
+            LogMsg(tr("Couldn't read RSS Session data from %1. Error: %2")
+                   .arg(m_dataFileName, file.errorString())
+                   , Log::WARNING);
+            return;
+        }
+
+        // corrupted data file must be rewritten before anything can be appended to it
+        m_hasDataFile = loadArticles(file.readAll());
+        m_dataFileSize = file.size();
         file.close();
     }
+    else if (jsonFile.exists()) {
+        if (!jsonFile.open(QFile::ReadOnly)) {
+            LogMsg(tr("Couldn't read RSS Session data from %1. Error: %2")
+                   .arg(jsonFile.fileName(), jsonFile.errorString())
+                   , Log::WARNING);
+            return;
+        }
+
+        loadArticlesFromJSON(jsonFile.readAll());
+        jsonFile.close();
+    }
     else {
+        loadArticlesLegacy();
+    }
+
+    updatePublishingStats();
+
+    // Loaded articles are already stored, unless they need to be converted to new format
+    m_pendingRecords.clear();
+    m_dirty = needsCompaction();
+    if (jsonFile.exists()) {
+        // legacy file is removed once the converted articles are saved
+        if (m_dirty)
+            connect(m_session->dataFileStorage(), &AsyncFileStorage::stored, this, &Feed::handleDataFileStored);
+        else
+            jsonFile.remove();
+    }
+
+    if (m_dirty)
+        store();
+    else
+        storeSummary();
+}
+
+void Feed::handleDataFileStored(const QString &filePath)
+{
+    const QDir storageDir {m_session->dataFileStorage()->storageDir()};
+    if (filePath != storageDir.absoluteFilePath(m_dataFileName))
+        return;
+
+    disconnect(m_session->dataFileStorage(), &AsyncFileStorage::stored, this, &Feed::handleDataFileStored);
+    Utils::Fs::forceRemove(storageDir.absoluteFilePath(jsonDataFileName(m_uid)));
+}
+
+void Feed::handleDataFileStorageFailed(const QString &filePath)
+{
+    const QDir storageDir {m_session->dataFileStorage()->storageDir()};
+    if (filePath != storageDir.absoluteFilePath(m_dataFileName))
+        return;
+
+    // Data file misses the records which weren't written, so it's rewritten
+    // from the loaded articles. Otherwise it's checked on the next loading.
+    m_hasDataFile = false;
+    if (m_isArticlesLoaded) {
+        m_dirty = true;
+        storeDeferred();
+    }
+}
+
+bool Feed::loadSummary(const qint64 dataFileSize)
+{
+    const QDir storageDir {m_session->dataFileStorage()->storageDir()};
+    QFile file(storageDir.absoluteFilePath(m_summaryFileName));
+    if (!file.open(QFile::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    in.setVersion(ARTICLES_FILE_STREAM_VERSION);
+
+    quint32 version = 0;
+    in >> version;
+    if (version != SUMMARY_FILE_VERSION)
+        return false;
+
+    qint64 summaryDataFileSize = 0;
+    qint32 articlesCount = 0;
+    qint32 unreadCount = 0;
+    qint32 recordsCount = 0;
+    QString eTag;
+    QString lastModified;
+    QDateTime newestArticleDate;
+    qint64 averagePublishingInterval = -1;
+    in >> summaryDataFileSize >> articlesCount >> unreadCount >> recordsCount >> eTag >> lastModified
+       >> newestArticleDate >> averagePublishingInterval;
+    // Summary is outdated if data file was changed after it had been stored
+    if ((in.status() != QDataStream::Ok) || (summaryDataFileSize != dataFileSize))
+        return false;
+
+    m_isArticlesLoaded = false;
+    m_hasDataFile = true;
+    m_dataFileSize = dataFileSize;
+    m_unloadedArticlesCount = articlesCount;
+    m_unreadCount = unreadCount;
+    m_recordsCount = recordsCount;
+    m_eTag = eTag;
+    m_lastModified = lastModified;
+    m_newestArticleDate = newestArticleDate;
+    m_averagePublishingInterval = averagePublishingInterval;
+    return true;
+}
+
+void Feed::storeSummary()
+{
+    if (!m_hasDataFile) return;
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(ARTICLES_FILE_STREAM_VERSION);
+    out << SUMMARY_FILE_VERSION << m_dataFileSize << static_cast<qint32>(articlesCount())
+        << static_cast<qint32>(m_unreadCount) << static_cast<qint32>(m_recordsCount) << m_eTag << m_lastModified
+        << m_newestArticleDate << m_averagePublishingInterval;
+
+    m_session->dataFileStorage()->store(m_summaryFileName, data);
+}
+
+void Feed::loadArticlesOnDemand()
+{
+    m_lastUsageTime = QDateTime::currentMSecsSinceEpoch();
+    if (m_isArticlesLoaded) return;
+
+    m_isArticlesLoaded = true;
+
+    const QDir storageDir {m_session->dataFileStorage()->storageDir()};
+    QFile file(storageDir.absoluteFilePath(m_dataFileName));
+    if (!file.open(QFile::ReadOnly)) {
         LogMsg(tr("Couldn't read RSS Session data from %1. Error: %2")
                .arg(m_dataFileName, file.errorString())
                , Log::WARNING);
+        return;
+    }
+
+    // Data file can lag behind the values kept in memory
+    // while the latest changes are still being written
+    const int unreadCount = m_unreadCount;
+    const int recordsCount = m_recordsCount;
+    const QString eTag = m_eTag;
+    const QString lastModified = m_lastModified;
+
+    m_unreadCount = 0;
+    {
+        // Loaded articles aren't new ones
+        const QSignalBlocker signalBlocker(this);
+        m_hasDataFile = loadArticles(file.readAll());
+    }
+    file.close();
+
+    updatePublishingStats();
+    m_pendingRecords.clear();
+    m_recordsCount = recordsCount;
+    m_eTag = eTag;
+    m_lastModified = lastModified;
+
+    if (!m_hasDataFile) {
+        // corrupted data file should be rewritten
+        m_dirty = true;
+        store();
     }
+
+    if (m_unreadCount != unreadCount)
+        emit unreadCountChanged(this);
 }
 
-void Feed::loadArticles(const QByteArray &data)
+void Feed::unloadArticles()
+{
+    if (!m_isArticlesLoaded) return;
+
+    // pending changes must be stored before
+    store();
+
+    for (Article *article : asConst(m_articlesByDate))
+        emit articleAboutToBeRemoved(article);
+
+    m_unloadedArticlesCount = m_articles.size();
+    qDeleteAll(m_articles);
+    m_articles.clear();
+    m_articlesByDate.clear();
+    m_internedStrings.clear();
+    m_isArticlesLoaded = false;
+}
+
+int Feed::articlesCount() const
+{
+    return (m_isArticlesLoaded ? m_articles.size() : m_unloadedArticlesCount);
+}
+
+void Feed::updatePublishingStats()
+{
+    // The articles are sorted by date, the newest first
+    const int statsSize = std::min(m_articlesByDate.size(), PUBLISHING_STATS_SIZE);
+    if (statsSize < 2) {
+        m_averagePublishingInterval = -1;
+        return;
+    }
+
+    const QDateTime newestDate = m_articlesByDate[0]->date();
+    const QDateTime oldestDate = m_articlesByDate[statsSize - 1]->date();
+    if (!newestDate.isValid() || !oldestDate.isValid()) {
+        m_averagePublishingInterval = -1;
+        return;
+    }
+
+    m_newestArticleDate = newestDate;
+    m_averagePublishingInterval = oldestDate.msecsTo(newestDate) / (statsSize - 1);
+}
+
+bool Feed::loadArticles(const QByteArray &data)
+{
+    const QByteArray header = articlesFileHeader();
+    if (!data.startsWith(header)) {
+        LogMsg(tr("Couldn't load RSS Session data. Invalid data format."), Log::WARNING);
+        return false;
+    }
+
+    int recordsCount = 0;
+    int pos = header.size();
+    bool isCorrupted = false;
+    while (pos < data.size()) {
+        if ((data.size() - pos) < static_cast<int>(sizeof(quint32))) {
+            isCorrupted = true;
+            break;
+        }
+
+        const quint32 recordSize = qFromBigEndian<quint32>(data.constData() + pos);
+        pos += sizeof(quint32);
+        if (recordSize > static_cast<quint32>(data.size() - pos)) {
+            // the last record was not completely written
+            isCorrupted = true;
+            break;
+        }
+
+        QDataStream in(QByteArray::fromRawData(data.constData() + pos, static_cast<int>(recordSize)));
+        in.setVersion(ARTICLES_FILE_STREAM_VERSION);
+        pos += recordSize;
+
+        quint8 type = 0;
+        QVariant payload;
+        in >> type;
+        if (!in.atEnd())
+            in >> payload;
+        if (in.status() != QDataStream::Ok) {
+            isCorrupted = true;
+            break;
+        }
+
+        ++recordsCount;
+        switch (static_cast<RecordType>(type)) {
+        case RecordType::AddArticle: {
+                const QVariantHash varHash = payload.toHash();
+                if (m_articles.contains(varHash.value(Article::KeyId).toString()))
+                    break;
+
+                auto article = new Article(this, varHash);
+                if (!addArticle(article))
+                    delete article;
+            }
+            break;
+        case RecordType::MarkArticleRead: {
+                Article *article = m_articles.value(payload.toString());
+                if (article && !article->isRead()) {
+                    article->m_isRead = true;
+                    decreaseUnreadCount();
+                }
+            }
+            break;
+        case RecordType::MarkAllRead:
+            for (Article *article : asConst(m_articles)) {
+                if (!article->isRead()) {
+                    article->m_isRead = true;
+                    decreaseUnreadCount();
+                }
+            }
+            break;
+        case RecordType::RemoveArticle:
+            if (Article *article = m_articles.value(payload.toString()))
+                removeArticle(article);
+            break;
+        case RecordType::SetHTTPValidators: {
+                const QVariantHash validators = payload.toHash();
+                m_eTag = validators.value(KEY_ETAG).toString();
+                m_lastModified = validators.value(KEY_LASTMODIFIED).toString();
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    m_recordsCount = recordsCount;
+
+    if (isCorrupted) {
+        LogMsg(tr("Couldn't load RSS article '%1#%2'. Invalid data format.").arg(m_url).arg(recordsCount)
+               , Log::WARNING);
+    }
+
+    return !isCorrupted;
+}
+
+void Feed::loadArticlesFromJSON(const QByteArray &data)
 {
     QJsonParseError jsonError;
     const QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &jsonError);
@@ -325,12 +766,31 @@ void Feed::store()
 
     m_dirty = false;
     m_savingTimer.stop();
+    m_lastUsageTime = QDateTime::currentMSecsSinceEpoch();
+
+    // Unloaded articles can't be compacted but new records can be still appended
+    if (m_isArticlesLoaded && needsCompaction()) {
+        // Rewrite the data file so it contains only the current articles (oldest first)
+        QByteArray data = articlesFileHeader();
+        if (!m_eTag.isEmpty() || !m_lastModified.isEmpty()) {
+            data += makeRecord(RecordType::SetHTTPValidators
+                               , QVariantHash {{KEY_ETAG, m_eTag}, {KEY_LASTMODIFIED, m_lastModified}});
+        }
+        for (auto it = m_articlesByDate.crbegin(); it != m_articlesByDate.crend(); ++it)
+            data += makeRecord(RecordType::AddArticle, (*it)->data());
 
-    QJsonArray jsonArr;
-    for (Article *article :asConst(m_articles))
-        jsonArr << article->toJsonObject();
+        m_session->dataFileStorage()->store(m_dataFileName, data);
+        m_recordsCount = m_articlesByDate.size();
+        m_hasDataFile = true;
+        m_dataFileSize = data.size();
+    }
+    else if (!m_pendingRecords.isEmpty()) {
+        m_session->dataFileStorage()->append(m_dataFileName, m_pendingRecords);
+        m_dataFileSize += m_pendingRecords.size();
+    }
 
-    m_session->dataFileStorage()->store(m_dataFileName, QJsonDocument(jsonArr).toJson());
+    m_pendingRecords.clear();
+    storeSummary();
 }
 
 void Feed::storeDeferred()
@@ -339,6 +799,17 @@ void Feed::storeDeferred()
         m_savingTimer.start(5 * 1000, this);
 }
 
+bool Feed::needsCompaction() const
+{
+    return (!m_hasDataFile || (m_recordsCount > std::max(MIN_RECORDS_TO_COMPACT, (2 * m_articles.size()))));
+}
+
+void Feed::appendRecord(const QByteArray &record)
+{
+    m_pendingRecords += record;
+    ++m_recordsCount;
+}
+
 bool Feed::addArticle(Article *article)
 {
     Q_ASSERT(article);
@@ -353,11 +824,10 @@ bool Feed::addArticle(Article *article)
 
     m_articles[article->guid()] = article;
     m_articlesByDate.insert(lowerBound, article);
-    if (!article->isRead()) {
+    if (!article->isRead())
         increaseUnreadCount();
-        connect(article, &Article::read, this, &Feed::handleArticleRead);
-    }
 
+    appendRecord(makeRecord(RecordType::AddArticle, article->data()));
     m_dirty = true;
     emit newArticle(article);
 
@@ -367,20 +837,28 @@ bool Feed::addArticle(Article *article)
     return true;
 }
 
-void Feed::removeOldestArticle()
+void Feed::removeArticle(Article *article)
 {
-    auto oldestArticle = m_articlesByDate.last();
-    emit articleAboutToBeRemoved(oldestArticle);
+    emit articleAboutToBeRemoved(article);
 
-    m_articles.remove(oldestArticle->guid());
-    m_articlesByDate.removeLast();
-    const bool isRead = oldestArticle->isRead();
-    delete oldestArticle;
+    m_articles.remove(article->guid());
+    if (m_articlesByDate.last() == article)
+        m_articlesByDate.removeLast();
+    else
+        m_articlesByDate.removeOne(article);
+    appendRecord(makeRecord(RecordType::RemoveArticle, article->guid()));
+    const bool isRead = article->isRead();
+    delete article;
 
     if (!isRead)
         decreaseUnreadCount();
 }
 
+void Feed::removeOldestArticle()
+{
+    removeArticle(m_articlesByDate.last());
+}
+
 void Feed::increaseUnreadCount()
 {
     ++m_unreadCount;
@@ -411,7 +889,6 @@ int Feed::updateArticles(const QList<QVariantHash> &loadedArticles)
     if (loadedArticles.empty())
         return 0;
 
-    QDateTime dummyPubDate {QDateTime::currentDateTime()};
     QVector<QVariantHash> newArticles;
     newArticles.reserve(loadedArticles.size());
     for (QVariantHash article : loadedArticles) {
@@ -420,13 +897,13 @@ int Feed::updateArticles(const QList<QVariantHash> &loadedArticles)
         // that are earlier than the dates of existing articles.
         const Article *existingArticle = articleByGUID(article[Article::KeyId].toString());
         if (existingArticle) {
-            dummyPubDate = existingArticle->date().addMSecs(-1);
+            m_dummyPubDate = existingArticle->date().addMSecs(-1);
             continue;
         }
 
         QVariant &articleDate = article[Article::KeyDate];
         if (!articleDate.toDateTime().isValid())
-            articleDate = dummyPubDate;
+            articleDate = m_dummyPubDate;
 
         newArticles.append(article);
     }
@@ -468,6 +945,7 @@ int Feed::updateArticles(const QList<QVariantHash> &loadedArticles)
         }
     });
 
+    updatePublishingStats();
     return newArticlesCount;
 }
 
@@ -488,6 +966,8 @@ QJsonValue Feed::toJsonValue(const bool withData) const
         jsonObj.insert(KEY_ISLOADING, isLoading());
         jsonObj.insert(KEY_HASERROR, hasError());
 
+        const_cast<Feed *>(this)->loadArticlesOnDemand();
+
         QJsonArray jsonArr;
         for (Article *article : asConst(m_articles))
             jsonArr << article->toJsonObject();
@@ -508,17 +988,48 @@ void Feed::handleSessionProcessingEnabledChanged(const bool enabled)
 
 void Feed::handleArticleRead(Article *article)
 {
-    article->disconnect(this);
     decreaseUnreadCount();
     emit articleRead(article);
+    appendRecord(makeRecord(RecordType::MarkArticleRead, article->guid()));
     // will be stored deferred
     m_dirty = true;
     storeDeferred();
 }
 
+QString Feed::internString(const QString &str)
+{
+    if (str.isEmpty())
+        return {};
+
+    const auto iter = m_internedStrings.constFind(str);
+    if (iter != m_internedStrings.cend())
+        return *iter;
+
+    m_internedStrings.insert(str);
+    return str;
+}
+
 void Feed::cleanup()
 {
-    Utils::Fs::forceRemove(m_session->dataFileStorage()->storageDir().absoluteFilePath(m_dataFileName));
+    const QDir storageDir {m_session->dataFileStorage()->storageDir()};
+    Utils::Fs::forceRemove(storageDir.absoluteFilePath(m_dataFileName));
+    Utils::Fs::forceRemove(storageDir.absoluteFilePath(m_summaryFileName));
+    Utils::Fs::forceRemove(storageDir.absoluteFilePath(jsonDataFileName(m_uid)));
+}
+
+void Feed::handleDataFileStorageFailed(const QString &filePath)
+{
+    const QDir storageDir {m_session->dataFileStorage()->storageDir()};
+    if (filePath != storageDir.absoluteFilePath(m_dataFileName))
+        return;
+
+    // Data file misses the records which weren't written, so it's rewritten
+    // from the loaded articles. Otherwise it's checked on the next loading.
+    m_hasDataFile = false;
+    if (m_isArticlesLoaded) {
+        m_dirty = true;
+        storeDeferred();
+    }
 }
 
 void Feed::timerEvent(QTimerEvent *event)
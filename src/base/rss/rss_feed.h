@@ -31,8 +31,11 @@
 #pragma once
 
 #include <QBasicTimer>
+#include <QByteArray>
+#include <QDateTime>
 #include <QHash>
 #include <QList>
+#include <QSet>
 #include <QUuid>
 
 #include "rss_item.h"
@@ -61,6 +64,7 @@ namespace RSS
         Q_OBJECT
         Q_DISABLE_COPY(Feed)
 
+        friend class Article;
         friend class Session;
 
         Feed(const QUuid &uid, const QString &url, const QString &path, Session *session);
@@ -92,24 +96,40 @@ namespace RSS
         void handleSessionProcessingEnabledChanged(bool enabled);
         void handleMaxArticlesPerFeedChanged(int n);
         void handleIconDownloadFinished(const Net::DownloadResult &result);
+        void handleValidatorsReceived(const QString &eTag, const QString &lastModified);
+        void handleDataReceived(const QByteArray &data);
         void handleDownloadFinished(const Net::DownloadResult &result);
-        void handleParsingFinished(const Private::ParsingResult &result);
-        void handleArticleRead(Article *article);
+        void handleArticlesParsed(int parsingID, const QList<QVariantHash> &articles);
+        void handleParsingFinished(int parsingID, const Private::ParsingResult &result);
+        void handleDataFileStored(const QString &filePath);
+        void handleDataFileStorageFailed(const QString &filePath);
 
     private:
         void timerEvent(QTimerEvent *event) override;
         void cleanup() override;
         void load();
-        void loadArticles(const QByteArray &data);
+        bool loadSummary(qint64 dataFileSize);
+        void storeSummary();
+        void loadArticlesOnDemand();
+        void unloadArticles();
+        int articlesCount() const;
+        void updatePublishingStats();
+        bool loadArticles(const QByteArray &data);
+        void loadArticlesFromJSON(const QByteArray &data);
         void loadArticlesLegacy();
         void store();
         void storeDeferred();
+        bool needsCompaction() const;
+        void appendRecord(const QByteArray &record);
         bool addArticle(Article *article);
+        void removeArticle(Article *article);
         void removeOldestArticle();
         void increaseUnreadCount();
         void decreaseUnreadCount();
         void downloadIcon();
         int updateArticles(const QList<QVariantHash> &loadedArticles);
+        void handleArticleRead(Article *article);
+        QString internString(const QString &str);
 
         Session *m_session;
         Private::Parser *m_parser;
@@ -121,11 +141,37 @@ namespace RSS
         bool m_isLoading = false;
         QHash<QString, Article *> m_articles;
         QList<Article *> m_articlesByDate;
+        // Repeated article strings (e.g. authors, names of extra fields) are shared between articles
+        QSet<QString> m_internedStrings;
         int m_unreadCount = 0;
         QString m_iconPath;
         QString m_dataFileName;
+        QString m_summaryFileName;
+        // Articles are loaded from the data file on first access only
+        // and can be unloaded again when they aren't used for a while
+        bool m_isArticlesLoaded = true;
+        int m_unloadedArticlesCount = 0;
+        qint64 m_lastUsageTime = 0;
+        qint64 m_dataFileSize = 0;
+        // Used to estimate how often the feed is published
+        QDateTime m_newestArticleDate;
+        qint64 m_averagePublishingInterval = -1;
         QBasicTimer m_savingTimer;
         bool m_dirty = false;
+        // Article changes are appended to the data file as records
+        // which are rewritten into a compact snapshot from time to time
+        QByteArray m_pendingRecords;
+        int m_recordsCount = 0;
+        bool m_hasDataFile = false;
         Net::DownloadHandler *m_downloadHandler = nullptr;
+        int m_parsingID = 0;
+        int m_newArticlesCount = 0;
+        // Fallback date of undated articles, shared by all batches of one update
+        QDateTime m_dummyPubDate;
+        // Validators of the last processed feed content, used to make conditional requests
+        QString m_eTag;
+        QString m_lastModified;
+        QString m_downloadedETag;
+        QString m_downloadedLastModified;
     };
 }
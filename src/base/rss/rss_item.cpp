@@ -63,6 +63,22 @@ QString Item::name() const
     return relativeName(path());
 }
 
+void Item::pinArticles()
+{
+    ++m_articlesPinCount;
+}
+
+void Item::unpinArticles()
+{
+    Q_ASSERT(m_articlesPinCount > 0);
+    --m_articlesPinCount;
+}
+
+bool Item::isArticlesPinned() const
+{
+    return (m_articlesPinCount > 0);
+}
+
 bool Item::isValidPath(const QString &path)
 {
     static const QRegularExpression re(
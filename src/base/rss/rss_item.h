@@ -56,6 +56,12 @@ namespace RSS
         QString path() const;
         QString name() const;
 
+        // Articles of pinned items (e.g. the ones being displayed) and of their
+        // subitems are kept loaded even if they aren't accessed for a while
+        void pinArticles();
+        void unpinArticles();
+        bool isArticlesPinned() const;
+
         virtual QJsonValue toJsonValue(bool withData = false) const = 0;
 
         static const QChar PathSeparator;
@@ -84,5 +90,6 @@ namespace RSS
         void setPath(const QString &path);
 
         QString m_path;
+        int m_articlesPinCount = 0;
     };
 }
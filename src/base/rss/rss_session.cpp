@@ -30,6 +30,10 @@
 
 #include "rss_session.h"
 
+#include <algorithm>
+#include <limits>
+
+#include <QDateTime>
 #include <QDebug>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -37,6 +41,8 @@
 #include <QSaveFile>
 #include <QString>
 #include <QThread>
+#include <QUrl>
+#include <QVector>
 
 #include "../asyncfilestorage.h"
 #include "../global.h"
@@ -44,6 +50,7 @@
 #include "../profile.h"
 #include "../settingsstorage.h"
 #include "../utils/fs.h"
+#include "../utils/random.h"
 #include "rss_article.h"
 #include "rss_feed.h"
 #include "rss_folder.h"
@@ -52,6 +59,13 @@
 #include <boost/numeric/conversion/cast.hpp>
 
 const int MsecsPerMin = 60000;
+const int MaxActiveRefreshes = 8;
+const int MaxActiveRefreshesPerHost = 2;
+// Refresh interval of rarely published feeds can be increased up to this factor
+const int MaxRefreshIntervalFactor = 8;
+// Articles of the least recently used feeds are unloaded when there are more of them loaded
+const int MaxLoadedArticles = 10000;
+const int ArticlesIdleTime = 5 * MsecsPerMin;
 const QString ConfFolderName(QStringLiteral("rss"));
 const QString DataFolderName(QStringLiteral("rss/articles"));
 const QString FeedsFileName(QStringLiteral("feeds.json"));
@@ -98,12 +112,16 @@ Session::Session()
     m_workingThread->start();
     load();
 
-    connect(&m_refreshTimer, &QTimer::timeout, this, &Session::refresh);
+    m_refreshTimer.setSingleShot(true);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &Session::processRefreshQueue);
     if (m_processingEnabled) {
-        m_refreshTimer.start(boost::numeric_cast<int>(m_refreshInterval * MsecsPerMin));
-        refresh();
+        scheduleAllFeeds(static_cast<qint64>(m_refreshInterval) * MsecsPerMin);
+        processRefreshQueue();
     }
 
+    connect(&m_articlesUnloadingTimer, &QTimer::timeout, this, &Session::unloadIdleArticles);
+    m_articlesUnloadingTimer.start(MsecsPerMin);
+
     // Remove legacy/corrupted settings
     // (at least on Windows, QSettings is case-insensitive and it can get
     // confused when asked about settings that differ only in their case)
@@ -419,6 +437,7 @@ void Session::addItem(Item *item, Folder *destFolder)
         connect(feed, &Feed::titleChanged, this, &Session::handleFeedTitleChanged);
         connect(feed, &Feed::iconLoaded, this, &Session::feedIconLoaded);
         connect(feed, &Feed::stateChanged, this, &Session::feedStateChanged);
+        connect(feed, &Feed::stateChanged, this, &Session::handleFeedStateChanged);
         m_feedsByUID[feed->uid()] = feed;
         m_feedsByURL[feed->url()] = feed;
     }
@@ -441,10 +460,12 @@ void Session::setProcessingEnabled(bool enabled)
         m_processingEnabled = enabled;
         SettingsStorage::instance()->storeValue(SettingsKey_ProcessingEnabled, m_processingEnabled);
         if (m_processingEnabled) {
-            m_refreshTimer.start(boost::numeric_cast<int>(m_refreshInterval * MsecsPerMin));
-            refresh();
+            scheduleAllFeeds(static_cast<qint64>(m_refreshInterval) * MsecsPerMin);
+            processRefreshQueue();
         }
         else {
+            m_feedRefreshTimes.clear();
+            m_feedsToSpread.clear();
             m_refreshTimer.stop();
         }
 
@@ -487,7 +508,15 @@ void Session::setRefreshInterval(const uint refreshInterval)
     if (m_refreshInterval != refreshInterval) {
         SettingsStorage::instance()->storeValue(SettingsKey_RefreshInterval, refreshInterval);
         m_refreshInterval = refreshInterval;
-        m_refreshTimer.start(boost::numeric_cast<int>(m_refreshInterval * MsecsPerMin));
+
+        // Feeds scheduled beyond the new interval are spread across it
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        const qint64 interval = static_cast<qint64>(m_refreshInterval) * MsecsPerMin;
+        for (auto it = m_feedRefreshTimes.begin(); it != m_feedRefreshTimes.end(); ++it) {
+            if ((it.value() - now) > interval)
+                it.value() = now + Utils::Random::rand(0, boost::numeric_cast<uint32_t>(interval));
+        }
+        m_refreshTimer.start(0);
     }
 }
 
@@ -503,6 +532,17 @@ void Session::handleItemAboutToBeDestroyed(Item *item)
     if (feed) {
         m_feedsByUID.remove(feed->uid());
         m_feedsByURL.remove(feed->url());
+        m_feedRefreshTimes.remove(feed);
+        m_feedsToSpread.remove(feed);
+
+        const auto refreshingIter = m_refreshingFeeds.find(feed);
+        if (refreshingIter != m_refreshingFeeds.end()) {
+            const QString host = refreshingIter.value();
+            m_refreshingFeeds.erase(refreshingIter);
+            if (--m_activeRefreshesByHost[host] <= 0)
+                m_activeRefreshesByHost.remove(host);
+            m_refreshTimer.start(0);
+        }
     }
 }
 
@@ -514,6 +554,152 @@ void Session::handleFeedTitleChanged(Feed *feed)
         moveItem(feed, Item::joinPath(Item::parentPath(feed->path()), feed->title()));
 }
 
+void Session::handleFeedStateChanged(Feed *feed)
+{
+    if (feed->isLoading()) return;
+
+    const auto refreshingIter = m_refreshingFeeds.find(feed);
+    if (refreshingIter != m_refreshingFeeds.end()) {
+        const QString host = refreshingIter.value();
+        m_refreshingFeeds.erase(refreshingIter);
+        if (--m_activeRefreshesByHost[host] <= 0)
+            m_activeRefreshesByHost.remove(host);
+    }
+
+    if (m_processingEnabled) {
+        qint64 delay = nextRefreshDelay(feed);
+        // Feeds refreshed all at once are spread across the whole interval next time
+        if (m_feedsToSpread.remove(feed))
+            delay = (delay / 2) + Utils::Random::rand(0, boost::numeric_cast<uint32_t>(delay));
+        m_feedRefreshTimes[feed] = QDateTime::currentMSecsSinceEpoch() + delay;
+    }
+    else {
+        m_feedRefreshTimes.remove(feed);
+    }
+
+    // Process it later to let the feed finish its update
+    m_refreshTimer.start(0);
+}
+
+void Session::processRefreshQueue()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    QVector<Feed *> dueFeeds;
+    qint64 nextRefreshTime = std::numeric_limits<qint64>::max();
+    for (auto it = m_feedRefreshTimes.cbegin(); it != m_feedRefreshTimes.cend(); ++it) {
+        if (it.value() <= now)
+            dueFeeds.append(it.key());
+        else
+            nextRefreshTime = std::min(nextRefreshTime, it.value());
+    }
+
+    // The longest waiting feeds go first
+    std::sort(dueFeeds.begin(), dueFeeds.end(), [this](Feed *left, Feed *right)
+    {
+        return (m_feedRefreshTimes.value(left) < m_feedRefreshTimes.value(right));
+    });
+
+    for (Feed *feed : asConst(dueFeeds)) {
+        if (m_refreshingFeeds.size() >= MaxActiveRefreshes)
+            break;
+
+        // Feed can be already refreshed or removed in the meantime
+        if (m_feedRefreshTimes.value(feed, std::numeric_limits<qint64>::max()) > now)
+            continue;
+        // Feed which is being refreshed manually will be rescheduled once it's finished
+        if (feed->isLoading())
+            continue;
+
+        const QString host = QUrl(feed->url()).host();
+        const int activeRefreshes = m_activeRefreshesByHost.value(host);
+        if (activeRefreshes >= MaxActiveRefreshesPerHost)
+            continue;
+
+        m_activeRefreshesByHost[host] = activeRefreshes + 1;
+        m_refreshingFeeds[feed] = host;
+        m_feedRefreshTimes.remove(feed);
+        feed->refresh();
+    }
+
+    // Due feeds which are left in the queue are processed once some of active refreshes is finished
+    if (nextRefreshTime != std::numeric_limits<qint64>::max())
+        m_refreshTimer.start(static_cast<int>(std::min<qint64>((nextRefreshTime - now), std::numeric_limits<int>::max())));
+}
+
+void Session::unloadIdleArticles()
+{
+    QVector<Feed *> loadedFeeds;
+    int loadedArticlesCount = 0;
+    for (Feed *feed : asConst(m_feedsByURL)) {
+        if (feed->m_isArticlesLoaded) {
+            loadedFeeds.append(feed);
+            loadedArticlesCount += feed->m_articles.size();
+        }
+    }
+
+    if (loadedArticlesCount <= MaxLoadedArticles) return;
+
+    std::sort(loadedFeeds.begin(), loadedFeeds.end(), [](const Feed *left, const Feed *right)
+    {
+        return (left->m_lastUsageTime < right->m_lastUsageTime);
+    });
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (Feed *feed : asConst(loadedFeeds)) {
+        if (loadedArticlesCount <= MaxLoadedArticles)
+            break;
+        if ((now - feed->m_lastUsageTime) < ArticlesIdleTime)
+            break; // all the remaining feeds are used recently
+        if (feed->isLoading() || feed->m_dirty || isArticlesPinned(feed))
+            continue;
+
+        loadedArticlesCount -= feed->m_articles.size();
+        feed->unloadArticles();
+    }
+}
+
+bool Session::isArticlesPinned(const Feed *feed) const
+{
+    if (rootFolder()->isArticlesPinned())
+        return true;
+
+    for (const QString &path : asConst(Item::expandPath(feed->path()))) {
+        const Item *item = m_itemsByPath.value(path);
+        if (item && item->isArticlesPinned())
+            return true;
+    }
+
+    return false;
+}
+
+// Feeds are due at random times within the given period from now,
+// so they aren't refreshed simultaneously in the following cycles
+void Session::scheduleAllFeeds(const qint64 period)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (Feed *feed : asConst(m_feedsByURL))
+        m_feedRefreshTimes[feed] = now + ((period > 0) ? Utils::Random::rand(0, boost::numeric_cast<uint32_t>(period)) : 0);
+}
+
+qint64 Session::nextRefreshDelay(const Feed *feed) const
+{
+    const qint64 refreshInterval = static_cast<qint64>(m_refreshInterval) * MsecsPerMin;
+    qint64 interval = refreshInterval;
+
+    // Feeds which are published rarely are refreshed less often.
+    // Publishing statistics are available even if the articles aren't loaded.
+    if (feed->m_averagePublishingInterval >= 0) {
+        const qint64 publishingInterval = std::max(feed->m_averagePublishingInterval
+                                                   , feed->m_newestArticleDate.msecsTo(QDateTime::currentDateTime()));
+        interval = qBound(refreshInterval, (publishingInterval / 4), (refreshInterval * MaxRefreshIntervalFactor));
+    }
+
+    // Random jitter (up to 10% of the interval) prevents feeds from being refreshed simultaneously
+    const qint64 jitter = interval / 10;
+    return (interval - jitter + Utils::Random::rand(0, boost::numeric_cast<uint32_t>(2 * jitter)));
+}
+
 QUuid Session::generateUID() const
 {
     QUuid uid = QUuid::createUuid();
@@ -540,5 +726,9 @@ void Session::setMaxArticlesPerFeed(const int n)
 void Session::refresh()
 {
     // NOTE: Should we allow manually refreshing for disabled session?
-    rootFolder()->refresh();
+    // Feeds are refreshed as soon as allowed by the limits of simultaneous refreshes
+    scheduleAllFeeds(0);
+    for (Feed *feed : asConst(m_feedsByURL))
+        m_feedsToSpread.insert(feed);
+    processRefreshQueue();
 }
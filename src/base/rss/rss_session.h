@@ -65,6 +65,7 @@
 #include <QHash>
 #include <QObject>
 #include <QPointer>
+#include <QSet>
 #include <QTimer>
 
 class QThread;
@@ -133,6 +134,9 @@ namespace RSS
     private slots:
         void handleItemAboutToBeDestroyed(Item *item);
         void handleFeedTitleChanged(Feed *feed);
+        void handleFeedStateChanged(Feed *feed);
+        void processRefreshQueue();
+        void unloadIdleArticles();
 
     private:
         QUuid generateUID() const;
@@ -144,6 +148,9 @@ namespace RSS
         Folder *addSubfolder(const QString &name, Folder *parentFolder);
         Feed *addFeedToFolder(const QUuid &uid, const QString &url, const QString &name, Folder *parentFolder);
         void addItem(Item *item, Folder *destFolder);
+        void scheduleAllFeeds(qint64 period);
+        bool isArticlesPinned(const Feed *feed) const;
+        qint64 nextRefreshDelay(const Feed *feed) const;
 
         static QPointer<Session> m_instance;
 
@@ -157,5 +164,12 @@ namespace RSS
         QHash<QString, Item *> m_itemsByPath;
         QHash<QUuid, Feed *> m_feedsByUID;
         QHash<QString, Feed *> m_feedsByURL;
+        // Each feed is refreshed on its own schedule, the number of
+        // simultaneous refreshes (in total and per host) is limited
+        QHash<Feed *, qint64> m_feedRefreshTimes;
+        QHash<Feed *, QString> m_refreshingFeeds;
+        QHash<QString, int> m_activeRefreshesByHost;
+        QSet<Feed *> m_feedsToSpread;
+        QTimer m_articlesUnloadingTimer;
     };
 }
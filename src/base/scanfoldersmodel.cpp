@@ -30,6 +30,7 @@
 
 #include <QDir>
 #include <QFileInfo>
+#include <QHash>
 #include <QStringList>
 #include <QTextStream>
 
@@ -80,6 +81,12 @@ ScanFoldersModel::ScanFoldersModel(QObject *parent)
 {
     configure();
     connect(Preferences::instance(), &Preferences::changed, this, &ScanFoldersModel::configure);
+    connect(BitTorrent::Session::instance(), &BitTorrent::Session::bulkAddTorrentFinished
+            , this, &ScanFoldersModel::handleTorrentFileProcessed);
+    connect(BitTorrent::Session::instance(), &BitTorrent::Session::bulkAddTorrentFailed
+            , this, &ScanFoldersModel::handleTorrentFileProcessed);
+    connect(BitTorrent::Session::instance(), &BitTorrent::Session::bulkAddTorrentLoadFailed
+            , this, &ScanFoldersModel::handleTorrentFileLoadFailed);
 }
 
 ScanFoldersModel::~ScanFoldersModel()
@@ -345,6 +352,9 @@ void ScanFoldersModel::configure()
 
 void ScanFoldersModel::addTorrentsToSession(const QStringList &pathList)
 {
+    // torrent files are added in bulk, grouped by save path
+    QHash<QString, QStringList> torrentFiles;
+
     for (const QString &file : pathList) {
         qDebug("File %s added", qUtf8Printable(file));
 
@@ -368,17 +378,30 @@ void ScanFoldersModel::addTorrentsToSession(const QStringList &pathList)
                 qDebug("Failed to open magnet file: %s", qUtf8Printable(f.errorString()));
             }
         }
-        else {
-            const BitTorrent::TorrentInfo torrentInfo = BitTorrent::TorrentInfo::loadFromFile(file);
-            if (torrentInfo.isValid()) {
-                BitTorrent::Session::instance()->addTorrent(torrentInfo, params);
-                Utils::Fs::forceRemove(file);
-            }
-            else {
-                qDebug("Ignoring incomplete torrent file: %s", qUtf8Printable(file));
-            }
+        else if (!m_addingTorrentFiles.contains(file)) {
+            m_addingTorrentFiles.insert(file);
+            torrentFiles[params.savePath].append(file);
         }
     }
+
+    for (auto i = torrentFiles.cbegin(); i != torrentFiles.cend(); ++i) {
+        BitTorrent::AddTorrentParams params;
+        params.savePath = i.key();
+        BitTorrent::Session::instance()->addTorrents(i.value(), params);
+    }
+}
+
+void ScanFoldersModel::handleTorrentFileProcessed(const QString &filePath)
+{
+    // valid torrent files are removed even if the session refused them
+    if (m_addingTorrentFiles.remove(filePath))
+        Utils::Fs::forceRemove(filePath);
+}
+
+void ScanFoldersModel::handleTorrentFileLoadFailed(const QString &filePath)
+{
+    if (m_addingTorrentFiles.remove(filePath))
+        qDebug("Ignoring incomplete torrent file: %s", qUtf8Printable(filePath));
 }
 
 QString ScanFoldersModel::pathTypeDisplayName(const PathType type)
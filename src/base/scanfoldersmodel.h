@@ -31,6 +31,7 @@
 
 #include <QAbstractListModel>
 #include <QList>
+#include <QSet>
 
 class QStringList;
 
@@ -94,6 +95,8 @@ public slots:
 
 private slots:
     void addTorrentsToSession(const QStringList &pathList);
+    void handleTorrentFileProcessed(const QString &filePath);
+    void handleTorrentFileLoadFailed(const QString &filePath);
 
 private:
     explicit ScanFoldersModel(QObject *parent = nullptr);
@@ -109,6 +112,7 @@ private:
     struct PathData;
 
     QList<PathData*> m_pathList;
+    QSet<QString> m_addingTorrentFiles;
     FileSystemWatcher *m_fsWatcher;
 };
 
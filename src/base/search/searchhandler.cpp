@@ -36,33 +36,54 @@
 #include "base/utils/foreignapps.h"
 #include "base/utils/fs.h"
 #include "searchpluginmanager.h"
+#include "searchworker.h"
 
-namespace
-{
-    enum SearchResultColumn
-    {
-        PL_DL_LINK,
-        PL_NAME,
-        PL_SIZE,
-        PL_SEEDS,
-        PL_LEECHS,
-        PL_ENGINE_URL,
-        PL_DESC_LINK,
-        NB_PLUGIN_COLUMNS
-    };
-}
-
-SearchHandler::SearchHandler(const QString &pattern, const QString &category, const QStringList &usedPlugins, SearchPluginManager *manager)
+SearchHandler::SearchHandler(const QString &pattern, const QString &category, const QStringList &usedPlugins
+                             , const QVector<SearchResult> &cachedResults, const bool isSearchNeeded, SearchPluginManager *manager)
     : QObject {manager}
     , m_pattern {pattern}
     , m_category {category}
     , m_usedPlugins {usedPlugins}
     , m_manager {manager}
-    , m_searchProcess {new QProcess {this}}
     , m_searchTimeout {new QTimer {this}}
+    , m_isCached {!cachedResults.isEmpty()}
 {
+    if (m_isCached) {
+        // deferred reporting allows clients to connect to the signals
+        QTimer::singleShot(0, this, [this, cachedResults]() { processSearchResults(cachedResults); });
+
+        if (!isSearchNeeded) {
+            m_isCachedSearchActive = true;
+            QTimer::singleShot(0, this, [this]()
+            {
+                // search can be cancelled in the meantime
+                if (!m_isCachedSearchActive)
+                    return;
+
+                m_isCachedSearchActive = false;
+                emit searchFinished(false);
+            });
+            return;
+        }
+    }
+
+    m_searchTimeout->setSingleShot(true);
+    connect(m_searchTimeout, &QTimer::timeout, this, &SearchHandler::handleSearchTimeout);
+    m_searchTimeout->start(180000); // 3 min
+
+    if (m_manager->searchWorker()) {
+        m_isWorkerSearchActive = true;
+        // deferred start allows clients to handle starting-related signals
+        QTimer::singleShot(0, this, &SearchHandler::startWorkerSearch);
+        return;
+    }
+
+    m_searchProcess = new QProcess {this};
     // Load environment variables (proxy)
-    m_searchProcess->setEnvironment(QProcess::systemEnvironment());
+    QStringList environment = QProcess::systemEnvironment();
+    // Ask novaprinter for the framed output
+    environment.append(QLatin1String("QBT_SEARCH_FRAMED_OUTPUT=1"));
+    m_searchProcess->setEnvironment(environment);
 
     const QStringList params {
         Utils::Fs::toNativePath(m_manager->engineLocation() + "/nova2.py"),
@@ -79,24 +100,45 @@ SearchHandler::SearchHandler(const QString &pattern, const QString &category, co
     connect(m_searchProcess, qOverload<int, QProcess::ExitStatus>(&QProcess::finished)
             , this, &SearchHandler::processFinished);
 
-    m_searchTimeout->setSingleShot(true);
-    connect(m_searchTimeout, &QTimer::timeout, this, &SearchHandler::cancelSearch);
-    m_searchTimeout->start(180000); // 3 min
-
     // deferred start allows clients to handle starting-related signals
     QTimer::singleShot(0, this, [this]() { m_searchProcess->start(QIODevice::ReadOnly); });
 }
 
+SearchHandler::~SearchHandler()
+{
+    // unlike search process, worker isn't stopped along with the handler
+    if (m_isWorkerSearchActive && m_searchWorker && (m_workerSearchID > 0))
+        m_searchWorker->cancelSearch(m_workerSearchID);
+}
+
 bool SearchHandler::isActive() const
 {
+    if (!m_searchProcess)
+        return (m_isWorkerSearchActive || m_isCachedSearchActive);
+
     return (m_searchProcess->state() != QProcess::NotRunning);
 }
 
+bool SearchHandler::isCached() const
+{
+    return m_isCached;
+}
+
 void SearchHandler::cancelSearch()
 {
-    if ((m_searchProcess->state() == QProcess::NotRunning) || m_searchCancelled)
+    if (!isActive() || m_searchCancelled)
         return;
 
+    if (!m_searchProcess) {
+        if (m_searchWorker && (m_workerSearchID > 0))
+            m_searchWorker->cancelSearch(m_workerSearchID);
+        m_searchCancelled = true;
+        m_isCachedSearchActive = false;
+        finishWorkerSearch();
+        emit searchFinished(true);
+        return;
+    }
+
 #ifdef Q_OS_WIN
     m_searchProcess->kill();
 #else
@@ -106,6 +148,17 @@ void SearchHandler::cancelSearch()
     m_searchTimeout->stop();
 }
 
+void SearchHandler::handleSearchTimeout()
+{
+    // Search which is run by worker can't be interrupted if some plugin hangs,
+    // so the worker is replaced to release the resources occupied by the search
+    const QPointer<SearchWorker> searchWorker = m_searchWorker;
+    const bool isWorkerSearch = m_isWorkerSearchActive;
+    cancelSearch();
+    if (isWorkerSearch)
+        m_manager->retireSearchWorker(searchWorker);
+}
+
 // Slot called when QProcess is Finished
 // QProcess can be finished for 3 reasons:
 // Error | Stopped by user | Finished normally
@@ -121,71 +174,102 @@ void SearchHandler::processFinished(const int exitcode)
         emit searchFailed();
 }
 
-// search QProcess return output as soon as it gets new
-// stuff to read. We split it into lines and parse each
-// line to SearchResult calling parseSearchResult().
-void SearchHandler::readSearchOutput()
+void SearchHandler::startWorkerSearch()
 {
-    QByteArray output = m_searchProcess->readAllStandardOutput();
-    output.replace('\r', "");
-
-    QList<QByteArray> lines = output.split('\n');
-    if (!m_searchResultLineTruncated.isEmpty())
-        lines.prepend(m_searchResultLineTruncated + lines.takeFirst());
-    m_searchResultLineTruncated = lines.takeLast().trimmed();
-
-    QVector<SearchResult> searchResultList;
-    searchResultList.reserve(lines.size());
+    // search can be cancelled before it is really started
+    if (!m_isWorkerSearchActive)
+        return;
 
-    for (const QByteArray &line : asConst(lines)) {
-        SearchResult searchResult;
-        if (parseSearchResult(QString::fromUtf8(line), searchResult))
-            searchResultList << searchResult;
+    // worker could be replaced in the meantime
+    m_searchWorker = m_manager->searchWorker();
+    if (!m_searchWorker) {
+        handleWorkerFailed();
+        return;
     }
 
-    if (!searchResultList.isEmpty()) {
-        for (const SearchResult &result : searchResultList)
-            m_results.append(result);
-        emit newSearchResults(searchResultList);
-    }
+    connect(m_searchWorker, &SearchWorker::searchResultsReceived, this, &SearchHandler::handleWorkerResults);
+    connect(m_searchWorker, &SearchWorker::searchFinished, this, &SearchHandler::handleWorkerSearchFinished);
+    connect(m_searchWorker, &SearchWorker::failed, this, &SearchHandler::handleWorkerFailed);
+    m_workerSearchID = m_searchWorker->startSearch(m_pattern, m_category, m_usedPlugins);
 }
 
-void SearchHandler::processFailed()
+void SearchHandler::handleWorkerResults(const int searchID, const QVector<SearchResult> &results)
 {
-    if (!m_searchCancelled)
-        emit searchFailed();
+    if (searchID == m_workerSearchID)
+        processSearchResults(results);
 }
 
-// Parse one line of search results list
-// Line is in the following form:
-// file url | file name | file size | nb seeds | nb leechers | Search engine url
-bool SearchHandler::parseSearchResult(const QString &line, SearchResult &searchResult)
+void SearchHandler::handleWorkerSearchFinished(const int searchID, const bool success)
 {
-    const QVector<QStringRef> parts = line.splitRef('|');
-    const int nbFields = parts.size();
+    if (searchID != m_workerSearchID)
+        return;
 
-    if (nbFields < (NB_PLUGIN_COLUMNS - 1)) return false; // -1 because desc_link is optional
+    finishWorkerSearch();
+    if (success)
+        emit searchFinished(false);
+    else
+        emit searchFailed();
+}
 
-    searchResult = SearchResult();
-    searchResult.fileUrl = parts.at(PL_DL_LINK).trimmed().toString(); // download URL
-    searchResult.fileName = parts.at(PL_NAME).trimmed().toString(); // Name
-    searchResult.fileSize = parts.at(PL_SIZE).trimmed().toLongLong(); // Size
+void SearchHandler::handleWorkerFailed()
+{
+    finishWorkerSearch();
+    emit searchFailed();
+}
+
+void SearchHandler::finishWorkerSearch()
+{
+    m_isWorkerSearchActive = false;
+    m_searchTimeout->stop();
+    if (m_searchWorker)
+        m_searchWorker->disconnect(this);
+}
 
-    bool ok = false;
+// search QProcess return output as soon as it gets new
+// stuff to read. Results framed by novaprinter are decoded
+// directly, other lines are parsed in the legacy text format.
+void SearchHandler::readSearchOutput()
+{
+    m_outputParser.addData(m_searchProcess->readAllStandardOutput());
 
-    searchResult.nbSeeders = parts.at(PL_SEEDS).trimmed().toLongLong(&ok); // Seeders
-    if (!ok || (searchResult.nbSeeders < 0))
-        searchResult.nbSeeders = -1;
+    QVector<SearchResult> searchResultList;
+    while (true) {
+        const SearchOutputParser::Item item = m_outputParser.readNext();
+        if (item == SearchOutputParser::Item::Result) {
+            searchResultList << m_outputParser.result();
+        }
+        else if (item == SearchOutputParser::Item::Line) {
+            // output of plugins which don't use novaprinter
+            SearchResult searchResult;
+            if (SearchOutputParser::parseResultLine(m_outputParser.line(), searchResult))
+                searchResultList << searchResult;
+        }
+        else {
+            break;
+        }
+    }
 
-    searchResult.nbLeechers = parts.at(PL_LEECHS).trimmed().toLongLong(&ok); // Leechers
-    if (!ok || (searchResult.nbLeechers < 0))
-        searchResult.nbLeechers = -1;
+    processSearchResults(searchResultList);
+}
 
-    searchResult.siteUrl = parts.at(PL_ENGINE_URL).trimmed().toString(); // Search site URL
-    if (nbFields == NB_PLUGIN_COLUMNS)
-        searchResult.descrLink = parts.at(PL_DESC_LINK).trimmed().toString(); // Description Link
+void SearchHandler::processSearchResults(const QVector<SearchResult> &searchResultList)
+{
+    if (!searchResultList.isEmpty()) {
+        // Duplicates of already found results aren't reported again
+        // but they still can update the statistics of existing ones
+        QVector<int> updatedRows;
+        const QVector<SearchResult> addedResults = m_results.addResults(searchResultList, &updatedRows);
+        if (!addedResults.isEmpty())
+            emit newSearchResults(addedResults);
+        if (!updatedRows.isEmpty())
+            emit searchResultsUpdated(updatedRows);
+    }
+}
 
-    return true;
+void SearchHandler::processFailed()
+{
+    if (!m_searchCancelled)
+        emit searchFailed();
 }
 
 SearchPluginManager *SearchHandler::manager() const
@@ -193,7 +277,7 @@ SearchPluginManager *SearchHandler::manager() const
     return m_manager;
 }
 
-QList<SearchResult> SearchHandler::results() const
+const SearchResultStore &SearchHandler::results() const
 {
     return m_results;
 }
@@ -29,27 +29,20 @@
 
 #pragma once
 
-#include <QByteArray>
 #include <QList>
 #include <QObject>
+#include <QPointer>
 #include <QString>
 #include <QVector>
 
+#include "searchoutputparser.h"
+#include "searchresultstore.h"
+
 class QProcess;
 class QTimer;
 
-struct SearchResult
-{
-    QString fileName;
-    QString fileUrl;
-    qlonglong fileSize;
-    qlonglong nbSeeders;
-    qlonglong nbLeechers;
-    QString siteUrl;
-    QString descrLink;
-};
-
 class SearchPluginManager;
+class SearchWorker;
 
 class SearchHandler : public QObject
 {
@@ -58,14 +51,18 @@ class SearchHandler : public QObject
 
     friend class SearchPluginManager;
 
-    SearchHandler(const QString &pattern, const QString &category
-                  , const QStringList &usedPlugins, SearchPluginManager *manager);
+    SearchHandler(const QString &pattern, const QString &category, const QStringList &usedPlugins
+                  , const QVector<SearchResult> &cachedResults, bool isSearchNeeded, SearchPluginManager *manager);
 
 public:
+    ~SearchHandler() override;
+
     bool isActive() const;
+    // Whether the results are initially taken from the cache
+    bool isCached() const;
     QString pattern() const;
     SearchPluginManager *manager() const;
-    QList<SearchResult> results() const;
+    const SearchResultStore &results() const;
 
     void cancelSearch();
 
@@ -73,20 +70,35 @@ signals:
     void searchFinished(bool cancelled = false);
     void searchFailed();
     void newSearchResults(const QVector<SearchResult> &results);
+    // Statistics of the results at given rows of the store are changed
+    void searchResultsUpdated(const QVector<int> &rows);
 
 private:
+    void handleSearchTimeout();
+    void startWorkerSearch();
+    void handleWorkerResults(int searchID, const QVector<SearchResult> &results);
+    void handleWorkerSearchFinished(int searchID, bool success);
+    void handleWorkerFailed();
+    void finishWorkerSearch();
     void readSearchOutput();
+    void processSearchResults(const QVector<SearchResult> &searchResultList);
     void processFailed();
     void processFinished(int exitcode);
-    bool parseSearchResult(const QString &line, SearchResult &searchResult);
 
     const QString m_pattern;
     const QString m_category;
     const QStringList m_usedPlugins;
     SearchPluginManager *m_manager;
-    QProcess *m_searchProcess;
+    // Search is run by a long-lived worker if it's available
+    QPointer<SearchWorker> m_searchWorker;
+    int m_workerSearchID = 0;
+    bool m_isWorkerSearchActive = false;
+    bool m_isCached = false;
+    // Cached results are reported without running the search
+    bool m_isCachedSearchActive = false;
+    QProcess *m_searchProcess = nullptr;
     QTimer *m_searchTimeout;
-    QByteArray m_searchResultLineTruncated;
+    SearchOutputParser m_outputParser;
     bool m_searchCancelled = false;
-    QList<SearchResult> m_results;
+    SearchResultStore m_results;
 };
@@ -0,0 +1,233 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2020  Eugene Shalygin <eugene.shalygin@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "searchoutputparser.h"
+
+#include <QString>
+#include <QtEndian>
+#include <QVector>
+
+namespace
+{
+    const char FRAME_MARKER = 0x1E;
+    const char FRAME_TYPE_RESULT = 'R';
+    const int FRAME_HEADER_SIZE = 2 + sizeof(quint32);
+    // novaprinter keeps the frames within PIPE_BUF, so larger ones are surely broken
+    const int MAX_FRAME_SIZE = 64 * 1024;
+
+    enum SearchResultColumn
+    {
+        PL_DL_LINK,
+        PL_NAME,
+        PL_SIZE,
+        PL_SEEDS,
+        PL_LEECHS,
+        PL_ENGINE_URL,
+        PL_DESC_LINK,
+        NB_PLUGIN_COLUMNS
+    };
+
+    // Reads typed fields of the frame body, it fails on the first malformed field
+    class FieldReader
+    {
+    public:
+        FieldReader(const char *data, const int size)
+            : m_data {data}
+            , m_end {data + size}
+        {
+        }
+
+        bool atEnd() const
+        {
+            return (m_data == m_end);
+        }
+
+        bool readInt(qint64 &value)
+        {
+            if (((m_end - m_data) < static_cast<int>(1 + sizeof(qint64))) || (*m_data != 'I'))
+                return false;
+
+            value = qFromBigEndian<qint64>(m_data + 1);
+            m_data += (1 + sizeof(qint64));
+            return true;
+        }
+
+        bool readString(QString &value)
+        {
+            if (((m_end - m_data) < static_cast<int>(1 + sizeof(quint32))) || (*m_data != 'S'))
+                return false;
+
+            const quint32 size = qFromBigEndian<quint32>(m_data + 1);
+            const char *stringData = m_data + 1 + sizeof(quint32);
+            if (size > static_cast<quint32>(m_end - stringData))
+                return false;
+
+            value = QString::fromUtf8(stringData, static_cast<int>(size));
+            m_data = stringData + size;
+            return true;
+        }
+
+    private:
+        const char *m_data;
+        const char *const m_end;
+    };
+}
+
+void SearchOutputParser::addData(const QByteArray &data)
+{
+    // Consumed data is discarded once per read instead of once per item
+    if (m_pos > 0) {
+        m_buffer.remove(0, m_pos);
+        m_pos = 0;
+    }
+
+    m_buffer.append(data);
+}
+
+SearchOutputParser::Item SearchOutputParser::readNext()
+{
+    while (m_pos < m_buffer.size()) {
+        const char *data = m_buffer.constData() + m_pos;
+        const int availableSize = m_buffer.size() - m_pos;
+
+        if (*data == FRAME_MARKER) {
+            if (availableSize < FRAME_HEADER_SIZE)
+                return Item::None;
+
+            const quint32 bodySize = qFromBigEndian<quint32>(data + 2);
+            if ((data[1] == FRAME_TYPE_RESULT) && (bodySize <= MAX_FRAME_SIZE)) {
+                const int frameSize = FRAME_HEADER_SIZE + static_cast<int>(bodySize);
+                if (availableSize < frameSize)
+                    return Item::None;
+
+                if (parseFrame((data + FRAME_HEADER_SIZE), static_cast<int>(bodySize))) {
+                    m_pos += frameSize;
+                    return Item::Result;
+                }
+            }
+
+            // Broken frame (e.g. mixed with output of another process),
+            // it is skipped up to the next frame or line below
+            ++m_pos;
+            continue;
+        }
+
+        // There are no frame markers in the text lines, so the data preceding
+        // the marker is the rest of a broken frame
+        const int lineEnd = m_buffer.indexOf('\n', m_pos);
+        const int nextFrame = m_buffer.indexOf(FRAME_MARKER, m_pos);
+        if ((nextFrame >= 0) && ((lineEnd < 0) || (nextFrame < lineEnd))) {
+            m_pos = nextFrame;
+            continue;
+        }
+        if (lineEnd < 0)
+            return Item::None;
+
+        int lineSize = lineEnd - m_pos;
+        if ((lineSize > 0) && (data[lineSize - 1] == '\r'))
+            --lineSize;
+        m_line = QByteArray(data, lineSize);
+        m_pos = lineEnd + 1;
+        return Item::Line;
+    }
+
+    return Item::None;
+}
+
+int SearchOutputParser::searchID() const
+{
+    return m_searchID;
+}
+
+const SearchResult &SearchOutputParser::result() const
+{
+    return m_result;
+}
+
+QByteArray SearchOutputParser::line() const
+{
+    return m_line;
+}
+
+bool SearchOutputParser::parseFrame(const char *data, const int size)
+{
+    FieldReader reader {data, size};
+
+    qint64 searchID = 0;
+    SearchResult result;
+    if (!reader.readInt(searchID)
+        || !reader.readString(result.fileUrl)
+        || !reader.readString(result.fileName)
+        || !reader.readInt(result.fileSize)
+        || !reader.readInt(result.nbSeeders)
+        || !reader.readInt(result.nbLeechers)
+        || !reader.readString(result.siteUrl))
+        return false;
+
+    // description link is optional
+    if (!reader.atEnd() && !reader.readString(result.descrLink))
+        return false;
+
+    if (result.nbSeeders < 0)
+        result.nbSeeders = -1;
+    if (result.nbLeechers < 0)
+        result.nbLeechers = -1;
+
+    m_searchID = static_cast<int>(searchID);
+    m_result = result;
+    return true;
+}
+
+bool SearchOutputParser::parseResultLine(const QByteArray &line, SearchResult &searchResult)
+{
+    const QVector<QStringRef> parts = QString::fromUtf8(line).splitRef('|');
+    const int nbFields = parts.size();
+
+    if (nbFields < (NB_PLUGIN_COLUMNS - 1)) return false; // -1 because desc_link is optional
+
+    searchResult = SearchResult();
+    searchResult.fileUrl = parts.at(PL_DL_LINK).trimmed().toString(); // download URL
+    searchResult.fileName = parts.at(PL_NAME).trimmed().toString(); // Name
+    searchResult.fileSize = parts.at(PL_SIZE).trimmed().toLongLong(); // Size
+
+    bool ok = false;
+
+    searchResult.nbSeeders = parts.at(PL_SEEDS).trimmed().toLongLong(&ok); // Seeders
+    if (!ok || (searchResult.nbSeeders < 0))
+        searchResult.nbSeeders = -1;
+
+    searchResult.nbLeechers = parts.at(PL_LEECHS).trimmed().toLongLong(&ok); // Leechers
+    if (!ok || (searchResult.nbLeechers < 0))
+        searchResult.nbLeechers = -1;
+
+    searchResult.siteUrl = parts.at(PL_ENGINE_URL).trimmed().toString(); // Search site URL
+    if (nbFields == NB_PLUGIN_COLUMNS)
+        searchResult.descrLink = parts.at(PL_DESC_LINK).trimmed().toString(); // Description Link
+
+    return true;
+}
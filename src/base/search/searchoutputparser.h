@@ -0,0 +1,77 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2020  Eugene Shalygin <eugene.shalygin@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QByteArray>
+
+#include "searchresultstore.h"
+
+// Reads the output of nova2 search processes. Results printed by novaprinter are
+// length-prefixed frames with typed fields, they are decoded directly from the read
+// buffer. Any other output is split into lines, so it can be handled the old way.
+// Broken frames are skipped up to the next frame marker.
+//
+// Frame layout (all integers are big-endian):
+//   0x1E 'R' <quint32 body size> <body>
+// Body is a sequence of fields, each of them is either
+//   'I' <qint64 value> or 'S' <quint32 size> <UTF-8 data>
+// Result fields are: search ID, file url, file name, file size, nb seeds, nb leechers,
+// search engine url and optional description link.
+class SearchOutputParser
+{
+public:
+    enum class Item
+    {
+        None, // more data is needed
+        Result,
+        Line
+    };
+
+    void addData(const QByteArray &data);
+    Item readNext();
+
+    // ID of the search the last read result belongs to, 0 if it isn't tagged
+    int searchID() const;
+    const SearchResult &result() const;
+    // Last read line, without line terminators
+    QByteArray line() const;
+
+    // Parses result in the legacy text format:
+    // file url | file name | file size | nb seeds | nb leechers | Search engine url [| description link]
+    static bool parseResultLine(const QByteArray &line, SearchResult &searchResult);
+
+private:
+    bool parseFrame(const char *data, int size);
+
+    QByteArray m_buffer;
+    int m_pos = 0;
+    int m_searchID = 0;
+    SearchResult m_result;
+    QByteArray m_line;
+};
@@ -31,6 +31,7 @@
 
 #include <memory>
 
+#include <QDateTime>
 #include <QDir>
 #include <QDirIterator>
 #include <QDomDocument>
@@ -44,14 +45,28 @@
 #include "base/net/downloadmanager.h"
 #include "base/preferences.h"
 #include "base/profile.h"
+#include "base/settingsstorage.h"
 #include "base/utils/bytearray.h"
 #include "base/utils/foreignapps.h"
 #include "base/utils/fs.h"
 #include "searchdownloadhandler.h"
 #include "searchhandler.h"
+#include "searchworker.h"
 
 namespace
 {
+    const QString SettingsKey_ResultCacheTTL(QStringLiteral("Search/ResultCache/TTL"));
+    const QString SettingsKey_ResultCacheSize(QStringLiteral("Search/ResultCache/Size"));
+    const QString SettingsKey_ResultCacheRefresh(QStringLiteral("Search/ResultCache/RefreshInBackground"));
+
+    // Approximate memory usage of the result in KiB, it is used as cost of cached search
+    int resultMemoryUsage(const SearchResult &result)
+    {
+        const int stringsSize = result.fileName.size() + result.fileUrl.size()
+                + result.siteUrl.size() + result.descrLink.size();
+        return ((static_cast<int>(sizeof(SearchResult)) + (stringsSize * static_cast<int>(sizeof(QChar)))) / 1024) + 1;
+    }
+
     void clearPythonCache(const QString &path)
     {
         // remove python cache artifacts in `path` and subdirs
@@ -82,6 +97,9 @@ QPointer<SearchPluginManager> SearchPluginManager::m_instance = nullptr;
 
 SearchPluginManager::SearchPluginManager()
     : m_updateUrl(QString("http://searchplugins.qbittorrent.org/%1/engines/").arg(Utils::ForeignApps::pythonInfo().version.majorNumber() >= 3 ? "nova3" : "nova"))
+    , m_resultCacheTTL(SettingsStorage::instance()->loadValue(SettingsKey_ResultCacheTTL, 10).toInt())
+    , m_isResultCacheRefreshEnabled(SettingsStorage::instance()->loadValue(SettingsKey_ResultCacheRefresh, false).toBool())
+    , m_resultCache(SettingsStorage::instance()->loadValue(SettingsKey_ResultCacheSize, 16).toInt() * 1024)
 {
     Q_ASSERT(!m_instance); // only one instance is allowed
     m_instance = this;
@@ -312,7 +330,150 @@ SearchHandler *SearchPluginManager::startSearch(const QString &pattern, const QS
     // No search pattern entered
     Q_ASSERT(!pattern.isEmpty());
 
-    return new SearchHandler {pattern, category, usedPlugins, this};
+    if (m_resultCacheTTL <= 0)
+        return new SearchHandler {pattern, category, usedPlugins, {}, false, this};
+
+    const QString cacheKey = resultCacheKey(pattern, category, usedPlugins);
+    QVector<SearchResult> cachedResults;
+    const CachedSearch *cachedSearch = m_resultCache.object(cacheKey);
+    if (cachedSearch && ((QDateTime::currentMSecsSinceEpoch() - cachedSearch->storeTime) < (m_resultCacheTTL * 60 * 1000))) {
+        ++m_resultCacheHits;
+        cachedResults = cachedSearch->results;
+    }
+    else {
+        ++m_resultCacheMisses;
+        if (cachedSearch)
+            m_resultCache.remove(cacheKey);
+    }
+
+    const bool isSearchNeeded = cachedResults.isEmpty() || m_isResultCacheRefreshEnabled;
+    auto *searchHandler = new SearchHandler {pattern, category, usedPlugins, cachedResults, isSearchNeeded, this};
+    if (isSearchNeeded) {
+        connect(searchHandler, &SearchHandler::searchFinished, this, [this, searchHandler, cacheKey](const bool cancelled)
+        {
+            // results of interrupted search are incomplete
+            if (!cancelled)
+                storeSearchResults(cacheKey, searchHandler->results());
+        });
+    }
+
+    return searchHandler;
+}
+
+SearchWorker *SearchPluginManager::searchWorker()
+{
+    // Worker mode is supported by Python 3 search engine only
+    if (Utils::ForeignApps::pythonInfo().version.majorNumber() < 3)
+        return nullptr;
+
+    if (!m_searchWorker)
+        m_searchWorker = new SearchWorker {engineLocation(), this};
+
+    return m_searchWorker;
+}
+
+void SearchPluginManager::retireSearchWorker(SearchWorker *worker)
+{
+    if (!worker) return;
+
+    worker->retire();
+    if (worker == m_searchWorker)
+        m_searchWorker = nullptr;
+}
+
+int SearchPluginManager::resultCacheTTL() const
+{
+    return m_resultCacheTTL;
+}
+
+void SearchPluginManager::setResultCacheTTL(const int minutes)
+{
+    if (m_resultCacheTTL == minutes)
+        return;
+
+    m_resultCacheTTL = minutes;
+    SettingsStorage::instance()->storeValue(SettingsKey_ResultCacheTTL, minutes);
+    if (minutes <= 0)
+        clearResultCache();
+}
+
+int SearchPluginManager::resultCacheSize() const
+{
+    return m_resultCache.maxCost() / 1024;
+}
+
+void SearchPluginManager::setResultCacheSize(const int mebibytes)
+{
+    if (resultCacheSize() == mebibytes)
+        return;
+
+    m_resultCache.setMaxCost(mebibytes * 1024);
+    SettingsStorage::instance()->storeValue(SettingsKey_ResultCacheSize, mebibytes);
+}
+
+bool SearchPluginManager::isResultCacheRefreshEnabled() const
+{
+    return m_isResultCacheRefreshEnabled;
+}
+
+void SearchPluginManager::setResultCacheRefreshEnabled(const bool enabled)
+{
+    if (m_isResultCacheRefreshEnabled == enabled)
+        return;
+
+    m_isResultCacheRefreshEnabled = enabled;
+    SettingsStorage::instance()->storeValue(SettingsKey_ResultCacheRefresh, enabled);
+}
+
+qint64 SearchPluginManager::resultCacheHits() const
+{
+    return m_resultCacheHits;
+}
+
+qint64 SearchPluginManager::resultCacheMisses() const
+{
+    return m_resultCacheMisses;
+}
+
+int SearchPluginManager::resultCacheCount() const
+{
+    return m_resultCache.count();
+}
+
+void SearchPluginManager::clearResultCache()
+{
+    m_resultCache.clear();
+}
+
+QString SearchPluginManager::resultCacheKey(const QString &pattern, const QString &category, const QStringList &usedPlugins)
+{
+    QStringList plugins = usedPlugins;
+    plugins.sort();
+    plugins.removeDuplicates();
+
+    return (pattern.simplified().toLower() + QLatin1Char('\n') + category.toLower()
+            + QLatin1Char('\n') + plugins.join(QLatin1Char(',')));
+}
+
+void SearchPluginManager::storeSearchResults(const QString &cacheKey, const SearchResultStore &results)
+{
+    if ((m_resultCacheTTL <= 0) || results.isEmpty()) {
+        m_resultCache.remove(cacheKey);
+        return;
+    }
+
+    auto *cachedSearch = new CachedSearch;
+    cachedSearch->results.reserve(results.size());
+    cachedSearch->storeTime = QDateTime::currentMSecsSinceEpoch();
+
+    int cost = 0;
+    for (int row = 0; row < results.size(); ++row) {
+        cachedSearch->results.append(results.result(row));
+        cost += resultMemoryUsage(cachedSearch->results.last());
+    }
+
+    // too large searches are not cached at all
+    m_resultCache.insert(cacheKey, cachedSearch, cost);
 }
 
 QString SearchPluginManager::categoryFullName(const QString &categoryName)
@@ -431,6 +592,11 @@ void SearchPluginManager::updateNova()
 
 void SearchPluginManager::update()
 {
+    // Plugins are loaded once by search worker so it should be replaced
+    retireSearchWorker(m_searchWorker);
+    // Set of plugins could be changed so cached results can be outdated
+    clearResultCache();
+
     QProcess nova;
     nova.setProcessEnvironment(QProcessEnvironment::systemEnvironment());
 
@@ -29,11 +29,15 @@
 
 #pragma once
 
+#include <QCache>
 #include <QHash>
 #include <QMetaType>
 #include <QObject>
+#include <QPointer>
+#include <QVector>
 
 #include "base/utils/version.h"
+#include "searchresultstore.h"
 
 using PluginVersion = Utils::Version<unsigned short, 2>;
 Q_DECLARE_METATYPE(PluginVersion)
@@ -56,6 +60,7 @@ struct PluginInfo
 
 class SearchDownloadHandler;
 class SearchHandler;
+class SearchWorker;
 
 class SearchPluginManager : public QObject
 {
@@ -84,6 +89,22 @@ public:
 
     SearchHandler *startSearch(const QString &pattern, const QString &category, const QStringList &usedPlugins);
     SearchDownloadHandler *downloadTorrent(const QString &siteUrl, const QString &url);
+    SearchWorker *searchWorker();
+    // Retired worker is replaced by a new one on the next search
+    void retireSearchWorker(SearchWorker *worker);
+
+    // Results of the finished searches are reused by the same searches
+    // (i.e. with the same pattern, category and plugins) for a while
+    int resultCacheTTL() const;
+    void setResultCacheTTL(int minutes);
+    int resultCacheSize() const;
+    void setResultCacheSize(int mebibytes);
+    bool isResultCacheRefreshEnabled() const;
+    void setResultCacheRefreshEnabled(bool enabled);
+    qint64 resultCacheHits() const;
+    qint64 resultCacheMisses() const;
+    int resultCacheCount() const;
+    void clearResultCache();
 
     static PluginVersion getPluginVersion(const QString &filePath);
     static QString categoryFullName(const QString &categoryName);
@@ -113,10 +134,25 @@ private:
     void pluginDownloadFinished(const Net::DownloadResult &result);
 
     static QString pluginPath(const QString &name);
+    static QString resultCacheKey(const QString &pattern, const QString &category, const QStringList &usedPlugins);
+    void storeSearchResults(const QString &cacheKey, const SearchResultStore &results);
+
+    struct CachedSearch
+    {
+        QVector<SearchResult> results;
+        qint64 storeTime;
+    };
 
     static QPointer<SearchPluginManager> m_instance;
 
     const QString m_updateUrl;
 
     QHash<QString, PluginInfo*> m_plugins;
+    QPointer<SearchWorker> m_searchWorker;
+
+    int m_resultCacheTTL;
+    bool m_isResultCacheRefreshEnabled;
+    QCache<QString, CachedSearch> m_resultCache;
+    qint64 m_resultCacheHits = 0;
+    qint64 m_resultCacheMisses = 0;
 };
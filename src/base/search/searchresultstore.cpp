@@ -0,0 +1,267 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2020  Eugene Shalygin <eugene.shalygin@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "searchresultstore.h"
+
+#include <algorithm>
+
+#include "base/utils/string.h"
+
+namespace
+{
+    QString base32ToHex(const QString &base32)
+    {
+        QByteArray bytes;
+        bytes.reserve((base32.size() * 5) / 8);
+
+        quint32 buffer = 0;
+        int bitsCount = 0;
+        for (const QChar c : base32) {
+            const ushort code = c.toUpper().unicode();
+            quint32 value = 0;
+            if ((code >= 'A') && (code <= 'Z'))
+                value = code - 'A';
+            else if ((code >= '2') && (code <= '7'))
+                value = code - '2' + 26;
+            else
+                return {};
+
+            buffer = (buffer << 5) | value;
+            bitsCount += 5;
+            if (bitsCount >= 8) {
+                bitsCount -= 8;
+                bytes.append(static_cast<char>((buffer >> bitsCount) & 0xFF));
+            }
+        }
+
+        return QString::fromLatin1(bytes.toHex());
+    }
+
+    // Results of different plugins can refer to the same torrent by its info-hash
+    QString resultKey(const QString &fileUrl)
+    {
+        if (!fileUrl.startsWith(QLatin1String("magnet:"), Qt::CaseInsensitive))
+            return fileUrl;
+
+        const QLatin1String hashPrefix {"urn:btih:"};
+        const int prefixPos = fileUrl.indexOf(hashPrefix, 0, Qt::CaseInsensitive);
+        if (prefixPos < 0)
+            return fileUrl;
+
+        const int hashPos = prefixPos + hashPrefix.size();
+        int hashEnd = fileUrl.indexOf(QLatin1Char('&'), hashPos);
+        if (hashEnd < 0)
+            hashEnd = fileUrl.size();
+
+        const QString hash = fileUrl.mid(hashPos, (hashEnd - hashPos));
+        if (hash.size() == 40)
+            return (QLatin1String("btih:") + hash.toLower());
+        if (hash.size() == 32) {
+            const QString hexHash = base32ToHex(hash);
+            if (!hexHash.isEmpty())
+                return (QLatin1String("btih:") + hexHash);
+        }
+
+        return fileUrl;
+    }
+}
+
+int SearchResultStore::size() const
+{
+    return m_fileNames.size();
+}
+
+bool SearchResultStore::isEmpty() const
+{
+    return m_fileNames.isEmpty();
+}
+
+QString SearchResultStore::fileName(const int row) const
+{
+    return m_fileNames[row];
+}
+
+QString SearchResultStore::fileUrl(const int row) const
+{
+    return m_fileUrls[row];
+}
+
+qlonglong SearchResultStore::fileSize(const int row) const
+{
+    return m_fileSizes[row];
+}
+
+qlonglong SearchResultStore::nbSeeders(const int row) const
+{
+    return m_nbSeeders[row];
+}
+
+qlonglong SearchResultStore::nbLeechers(const int row) const
+{
+    return m_nbLeechers[row];
+}
+
+QString SearchResultStore::siteUrl(const int row) const
+{
+    return m_siteUrls[row];
+}
+
+QString SearchResultStore::descrLink(const int row) const
+{
+    return m_descrLinks[row];
+}
+
+SearchResult SearchResultStore::result(const int row) const
+{
+    return {m_fileNames[row], m_fileUrls[row], m_fileSizes[row], m_nbSeeders[row]
+            , m_nbLeechers[row], m_siteUrls[row], m_descrLinks[row]};
+}
+
+QVector<SearchResult> SearchResultStore::addResults(const QVector<SearchResult> &results, QVector<int> *updatedRows)
+{
+    const int firstNewRow = size();
+
+    QVector<SearchResult> addedResults;
+    addedResults.reserve(results.size());
+    QVector<int> changedRows;
+    bool isSeedersChanged = false;
+    for (const SearchResult &result : results) {
+        const QString key = resultKey(result.fileUrl);
+        const auto rowIter = m_rowsByKey.constFind(key);
+        if (rowIter != m_rowsByKey.cend()) {
+            // Duplicate result can have more recent statistics
+            const int row = rowIter.value();
+            bool isChanged = false;
+            if (result.nbSeeders > m_nbSeeders[row]) {
+                m_nbSeeders[row] = result.nbSeeders;
+                isSeedersChanged = true;
+                isChanged = true;
+            }
+            if (result.nbLeechers > m_nbLeechers[row]) {
+                m_nbLeechers[row] = result.nbLeechers;
+                isChanged = true;
+            }
+            // rows added by this call aren't reported as updated
+            if (isChanged && (row < firstNewRow))
+                changedRows.append(row);
+            continue;
+        }
+
+        m_rowsByKey.insert(key, size());
+        m_fileNames.append(result.fileName);
+        m_fileUrls.append(result.fileUrl);
+        m_fileSizes.append(result.fileSize);
+        m_nbSeeders.append(result.nbSeeders);
+        m_nbLeechers.append(result.nbLeechers);
+        m_siteUrls.append(result.siteUrl);
+        m_descrLinks.append(result.descrLink);
+        addedResults.append(result);
+    }
+
+    if (!addedResults.isEmpty()) {
+        updateSortIndex(SortKey::Name, firstNewRow, false);
+        updateSortIndex(SortKey::Size, firstNewRow, false);
+    }
+    if (!addedResults.isEmpty() || isSeedersChanged)
+        updateSortIndex(SortKey::Seeders, firstNewRow, isSeedersChanged);
+
+    if (updatedRows) {
+        std::sort(changedRows.begin(), changedRows.end());
+        changedRows.erase(std::unique(changedRows.begin(), changedRows.end()), changedRows.end());
+        *updatedRows = changedRows;
+    }
+
+    return addedResults;
+}
+
+QVector<int> SearchResultStore::sortedRows(const SortKey sortKey, const bool reverse, const int offset, const int limit) const
+{
+    const QVector<int> &sortIndex = m_sortIndexes[static_cast<int>(sortKey)];
+    const int first = std::min(std::max(offset, 0), sortIndex.size());
+    const int count = (limit < 0) ? (sortIndex.size() - first) : std::min(limit, (sortIndex.size() - first));
+
+    QVector<int> rows;
+    rows.reserve(count);
+    if (reverse) {
+        for (int i = 0; i < count; ++i)
+            rows.append(sortIndex[sortIndex.size() - 1 - first - i]);
+    }
+    else {
+        for (int i = 0; i < count; ++i)
+            rows.append(sortIndex[first + i]);
+    }
+
+    return rows;
+}
+
+int SearchResultStore::rank(const SortKey sortKey, const int row) const
+{
+    return m_ranks[static_cast<int>(sortKey)][row];
+}
+
+bool SearchResultStore::lessThan(const SortKey sortKey, const int left, const int right) const
+{
+    // Rows are compared by their indexes if the values are equal so the order is stable
+    switch (sortKey) {
+    case SortKey::Name: {
+            const int result = Utils::String::naturalCompare(m_fileNames[left], m_fileNames[right], Qt::CaseInsensitive);
+            return (result != 0) ? (result < 0) : (left < right);
+        }
+    case SortKey::Size:
+        return (m_fileSizes[left] != m_fileSizes[right]) ? (m_fileSizes[left] < m_fileSizes[right]) : (left < right);
+    case SortKey::Seeders:
+        return (m_nbSeeders[left] != m_nbSeeders[right]) ? (m_nbSeeders[left] < m_nbSeeders[right]) : (left < right);
+    default:
+        Q_ASSERT(false);
+        return (left < right);
+    }
+}
+
+void SearchResultStore::updateSortIndex(const SortKey sortKey, const int firstNewRow, const bool isExistingRowsChanged)
+{
+    QVector<int> &sortIndex = m_sortIndexes[static_cast<int>(sortKey)];
+    const auto compare = [this, sortKey](const int left, const int right) { return lessThan(sortKey, left, right); };
+
+    const int oldSize = sortIndex.size();
+    for (int row = firstNewRow; row < size(); ++row)
+        sortIndex.append(row);
+
+    if (isExistingRowsChanged) {
+        std::sort(sortIndex.begin(), sortIndex.end(), compare);
+    }
+    else {
+        // New rows are sorted separately and then merged with the existing ones
+        std::sort((sortIndex.begin() + oldSize), sortIndex.end(), compare);
+        std::inplace_merge(sortIndex.begin(), (sortIndex.begin() + oldSize), sortIndex.end(), compare);
+    }
+
+    QVector<int> &ranks = m_ranks[static_cast<int>(sortKey)];
+    ranks.resize(sortIndex.size());
+    for (int i = 0; i < sortIndex.size(); ++i)
+        ranks[sortIndex[i]] = i;
+}
@@ -0,0 +1,96 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2020  Eugene Shalygin <eugene.shalygin@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+struct SearchResult
+{
+    QString fileName;
+    QString fileUrl;
+    qlonglong fileSize;
+    qlonglong nbSeeders;
+    qlonglong nbLeechers;
+    QString siteUrl;
+    QString descrLink;
+};
+
+// Search results are stored column-wise. Results which refer to the same torrent
+// (e.g. found by different plugins) are merged. Rows are kept sorted by some of the
+// columns, so sorted pages of results can be requested without sorting them again.
+class SearchResultStore
+{
+public:
+    enum class SortKey
+    {
+        Name,
+        Size,
+        Seeders,
+
+        Count
+    };
+
+    int size() const;
+    bool isEmpty() const;
+
+    QString fileName(int row) const;
+    QString fileUrl(int row) const;
+    qlonglong fileSize(int row) const;
+    qlonglong nbSeeders(int row) const;
+    qlonglong nbLeechers(int row) const;
+    QString siteUrl(int row) const;
+    QString descrLink(int row) const;
+    SearchResult result(int row) const;
+
+    // Returns the results which are really added, i.e. not duplicates of the existing ones.
+    // Rows whose statistics are updated by the duplicates are stored to `updatedRows`.
+    QVector<SearchResult> addResults(const QVector<SearchResult> &results, QVector<int> *updatedRows = nullptr);
+
+    QVector<int> sortedRows(SortKey sortKey, bool reverse, int offset = 0, int limit = -1) const;
+    // Position of the row in the order of the given sort key
+    int rank(SortKey sortKey, int row) const;
+
+private:
+    bool lessThan(SortKey sortKey, int left, int right) const;
+    void updateSortIndex(SortKey sortKey, int firstNewRow, bool isExistingRowsChanged);
+
+    QVector<QString> m_fileNames;
+    QVector<QString> m_fileUrls;
+    QVector<qlonglong> m_fileSizes;
+    QVector<qlonglong> m_nbSeeders;
+    QVector<qlonglong> m_nbLeechers;
+    QVector<QString> m_siteUrls;
+    QVector<QString> m_descrLinks;
+
+    QHash<QString, int> m_rowsByKey;
+    QVector<int> m_sortIndexes[static_cast<int>(SortKey::Count)];
+    QVector<int> m_ranks[static_cast<int>(SortKey::Count)];
+};
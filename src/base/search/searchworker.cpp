@@ -0,0 +1,215 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2020  Eugene Shalygin <eugene.shalygin@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "searchworker.h"
+
+#include <QProcess>
+#include <QTimer>
+
+#include "base/utils/foreignapps.h"
+#include "base/utils/fs.h"
+
+namespace
+{
+    // Searches which aren't finished by then are supposed to hang
+    const int RETIRED_WORKER_TIMEOUT = 180000; // 3 min
+
+    QString sanitizeField(QString field)
+    {
+        // request fields are separated by tabs and requests by newlines
+        field.replace('\t', ' ');
+        field.replace('\r', ' ');
+        field.replace('\n', ' ');
+        return field;
+    }
+}
+
+SearchWorker::SearchWorker(const QString &engineLocation, QObject *parent)
+    : QObject {parent}
+    , m_process {new QProcess {this}}
+{
+    // Load environment variables (proxy)
+    QStringList environment = QProcess::systemEnvironment();
+    // Ask novaprinter for the framed output
+    environment.append(QLatin1String("QBT_SEARCH_FRAMED_OUTPUT=1"));
+    m_process->setEnvironment(environment);
+    // Plugin errors are of no interest here but they must not be accumulated
+    m_process->setStandardErrorFile(QProcess::nullDevice());
+
+    m_process->setProgram(Utils::ForeignApps::pythonInfo().executableName);
+    m_process->setArguments({Utils::Fs::toNativePath(engineLocation + "/nova2.py"), "--worker"});
+
+    connect(m_process, &QProcess::readyReadStandardOutput, this, &SearchWorker::readOutput);
+    connect(m_process, qOverload<int, QProcess::ExitStatus>(&QProcess::finished)
+            , this, &SearchWorker::handleProcessFinished);
+    connect(m_process, &QProcess::errorOccurred, this, [this](const QProcess::ProcessError error)
+    {
+        if (error == QProcess::FailedToStart)
+            handleProcessFinished();
+    });
+
+    m_process->start(QIODevice::ReadWrite);
+}
+
+SearchWorker::~SearchWorker()
+{
+    if (m_process->state() != QProcess::NotRunning) {
+        m_process->disconnect(this);
+        m_process->kill();
+        m_process->waitForFinished();
+    }
+}
+
+bool SearchWorker::isRunning() const
+{
+    return (m_process->state() != QProcess::NotRunning);
+}
+
+int SearchWorker::startSearch(const QString &pattern, const QString &category, const QStringList &usedPlugins)
+{
+    Q_ASSERT(!m_isRetired);
+
+    const int searchID = ++m_lastSearchID;
+    ++m_activeSearchCount;
+    sendRequest({QLatin1String("search"), QString::number(searchID), usedPlugins.join(',')
+                 , category, pattern});
+    return searchID;
+}
+
+void SearchWorker::cancelSearch(const int searchID)
+{
+    // Output of cancelled search is ignored by its handler but the search itself can be
+    // already in progress so it is still considered as active until it is finished
+    if (m_isRetired)
+        return; // requests can't be sent anymore
+
+    sendRequest({QLatin1String("cancel"), QString::number(searchID)});
+}
+
+void SearchWorker::retire()
+{
+    m_isRetired = true;
+    // worker exits once active searches are finished
+    m_process->closeWriteChannel();
+    if (m_activeSearchCount == 0) {
+        deleteLater();
+        return;
+    }
+
+    // plugin calls can't be interrupted, so the process is killed if they hang
+    QTimer::singleShot(RETIRED_WORKER_TIMEOUT, this, [this]() { m_process->kill(); });
+}
+
+void SearchWorker::sendRequest(const QStringList &fields)
+{
+    QStringList sanitizedFields;
+    sanitizedFields.reserve(fields.size());
+    for (const QString &field : fields)
+        sanitizedFields.append(sanitizeField(field));
+
+    m_process->write(sanitizedFields.join('\t').toUtf8() + '\n');
+}
+
+void SearchWorker::readOutput()
+{
+    m_outputParser.addData(m_process->readAllStandardOutput());
+
+    // Consecutive results of the same search are reported at once
+    QVector<SearchResult> results;
+    int resultsSearchID = 0;
+    while (true) {
+        const SearchOutputParser::Item item = m_outputParser.readNext();
+        if (item == SearchOutputParser::Item::Result)
+            appendResult(m_outputParser.searchID(), m_outputParser.result(), results, resultsSearchID);
+        else if (item == SearchOutputParser::Item::Line)
+            processMessage(m_outputParser.line(), results, resultsSearchID);
+        else
+            break;
+    }
+
+    if (!results.isEmpty())
+        emit searchResultsReceived(resultsSearchID, results);
+}
+
+void SearchWorker::appendResult(const int searchID, const SearchResult &result, QVector<SearchResult> &results, int &resultsSearchID)
+{
+    if (searchID != resultsSearchID) {
+        if (!results.isEmpty())
+            emit searchResultsReceived(resultsSearchID, results);
+        results.clear();
+        resultsSearchID = searchID;
+    }
+
+    results.append(result);
+}
+
+void SearchWorker::processMessage(const QByteArray &message, QVector<SearchResult> &results, int &resultsSearchID)
+{
+    // Message is in the following form:
+    // type<TAB>search ID<TAB>payload
+    const int typeEnd = message.indexOf('\t');
+    if (typeEnd < 0) return;
+    const int idEnd = message.indexOf('\t', (typeEnd + 1));
+    if (idEnd < 0) return;
+
+    bool ok = false;
+    const int searchID = message.mid((typeEnd + 1), (idEnd - typeEnd - 1)).toInt(&ok);
+    if (!ok) return;
+
+    const QByteArray type = message.left(typeEnd);
+    const QByteArray payload = message.mid(idEnd + 1);
+
+    if (type == "result") {
+        // result in the legacy text format
+        SearchResult result;
+        if (SearchOutputParser::parseResultLine(payload, result))
+            appendResult(searchID, result, results, resultsSearchID);
+    }
+    else if (type == "finished") {
+        if (!results.isEmpty()) {
+            emit searchResultsReceived(resultsSearchID, results);
+            results.clear();
+            resultsSearchID = 0;
+        }
+
+        --m_activeSearchCount;
+        emit searchFinished(searchID, (payload == "1"));
+
+        if (m_isRetired && (m_activeSearchCount == 0))
+            deleteLater();
+    }
+}
+
+void SearchWorker::handleProcessFinished()
+{
+    if (!m_isRetired || (m_activeSearchCount > 0))
+        emit failed();
+
+    m_activeSearchCount = 0;
+    deleteLater();
+}
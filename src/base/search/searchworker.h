@@ -0,0 +1,77 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2020  Eugene Shalygin <eugene.shalygin@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "searchoutputparser.h"
+
+class QProcess;
+
+// Long-lived nova2 process which serves search requests
+// so plugins don't need to be loaded again for each search
+class SearchWorker final : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(SearchWorker)
+
+public:
+    explicit SearchWorker(const QString &engineLocation, QObject *parent = nullptr);
+    ~SearchWorker() override;
+
+    bool isRunning() const;
+
+    int startSearch(const QString &pattern, const QString &category, const QStringList &usedPlugins);
+    void cancelSearch(int searchID);
+    // Worker doesn't accept new searches anymore and it is deleted as soon as
+    // the active ones are finished (or they fail if it takes too long)
+    void retire();
+
+signals:
+    void searchResultsReceived(int searchID, const QVector<SearchResult> &results);
+    void searchFinished(int searchID, bool success);
+    void failed();
+
+private:
+    void readOutput();
+    void processMessage(const QByteArray &message, QVector<SearchResult> &results, int &resultsSearchID);
+    void appendResult(int searchID, const SearchResult &result, QVector<SearchResult> &results, int &resultsSearchID);
+    void handleProcessFinished();
+    void sendRequest(const QStringList &fields);
+
+    QProcess *m_process;
+    SearchOutputParser m_outputParser;
+    int m_lastSearchID = 0;
+    int m_activeSearchCount = 0;
+    bool m_isRetired = false;
+};
@@ -110,6 +110,9 @@ enum AdvSettingsRows
     // embedded tracker
     TRACKER_STATUS,
     TRACKER_PORT,
+    TRACKER_UDP_PORT,
+    TRACKER_MAX_TORRENTS,
+    TRACKER_MAX_PEERS_PER_TORRENT,
     // seeding
     CHOKING_ALGORITHM,
     SEED_CHOKING_ALGORITHM,
@@ -253,6 +256,9 @@ void AdvancedSettings::saveAdvancedSettings()
 
     // Tracker
     pref->setTrackerPort(m_spinBoxTrackerPort.value());
+    pref->setTrackerUDPPort(m_spinBoxTrackerUDPPort.value());
+    pref->setTrackerMaxTorrents(m_spinBoxTrackerMaxTorrents.value());
+    pref->setTrackerMaxPeersPerTorrent(m_spinBoxTrackerMaxPeersPerTorrent.value());
     session->setTrackerEnabled(m_checkBoxTrackerStatus.isChecked());
     // Choking algorithm
     session->setChokingAlgorithm(static_cast<BitTorrent::ChokingAlgorithm>(m_comboBoxChokingAlgorithm.currentIndex()));
@@ -562,6 +568,22 @@ void AdvancedSettings::loadAdvancedSettings()
     m_spinBoxTrackerPort.setMaximum(65535);
     m_spinBoxTrackerPort.setValue(pref->getTrackerPort());
     addRow(TRACKER_PORT, tr("Embedded tracker port"), &m_spinBoxTrackerPort);
+    // Tracker UDP port
+    m_spinBoxTrackerUDPPort.setMinimum(0);
+    m_spinBoxTrackerUDPPort.setMaximum(65535);
+    m_spinBoxTrackerUDPPort.setSpecialValueText(tr("Disabled"));
+    m_spinBoxTrackerUDPPort.setValue(pref->getTrackerUDPPort());
+    addRow(TRACKER_UDP_PORT, tr("Embedded tracker UDP port"), &m_spinBoxTrackerUDPPort);
+    // Tracker max torrents
+    m_spinBoxTrackerMaxTorrents.setMinimum(1);
+    m_spinBoxTrackerMaxTorrents.setMaximum(1000000);
+    m_spinBoxTrackerMaxTorrents.setValue(pref->getTrackerMaxTorrents());
+    addRow(TRACKER_MAX_TORRENTS, tr("Embedded tracker maximum torrents"), &m_spinBoxTrackerMaxTorrents);
+    // Tracker max peers per torrent
+    m_spinBoxTrackerMaxPeersPerTorrent.setMinimum(1);
+    m_spinBoxTrackerMaxPeersPerTorrent.setMaximum(100000);
+    m_spinBoxTrackerMaxPeersPerTorrent.setValue(pref->getTrackerMaxPeersPerTorrent());
+    addRow(TRACKER_MAX_PEERS_PER_TORRENT, tr("Embedded tracker maximum peers per torrent"), &m_spinBoxTrackerMaxPeersPerTorrent);
     // Choking algorithm
     m_comboBoxChokingAlgorithm.addItems({tr("Fixed slots"), tr("Upload rate based")});
     m_comboBoxChokingAlgorithm.setCurrentIndex(static_cast<int>(session->chokingAlgorithm()));
@@ -353,11 +353,22 @@ void PeerListWidget::loadPeers(const BitTorrent::TorrentHandle *torrent)
     for (auto i = m_peerItems.cbegin(); i != m_peerItems.cend(); ++i)
         existingPeers << i.key();
 
-    for (const BitTorrent::PeerInfo &peer : peers) {
+    // resolve all countries at once
+    QVector<QString> countries;
+    if (m_resolveCountries) {
+        QVector<QHostAddress> addresses;
+        addresses.reserve(peers.size());
+        for (const BitTorrent::PeerInfo &peer : peers)
+            addresses.append(peer.address().ip);
+        countries = Net::GeoIPManager::instance()->lookup(addresses);
+    }
+
+    for (int i = 0; i < peers.size(); ++i) {
+        const BitTorrent::PeerInfo &peer = peers[i];
         if (peer.address().ip.isNull()) continue;
 
         bool isNewPeer = false;
-        updatePeer(torrent, peer, isNewPeer);
+        updatePeer(torrent, peer, (m_resolveCountries ? countries[i] : QString()), isNewPeer);
         if (!isNewPeer) {
             const PeerEndpoint peerEndpoint {peer.address(), peer.connectionType()};
             existingPeers.remove(peerEndpoint);
@@ -377,7 +388,7 @@ void PeerListWidget::loadPeers(const BitTorrent::TorrentHandle *torrent)
     }
 }
 
-void PeerListWidget::updatePeer(const BitTorrent::TorrentHandle *torrent, const BitTorrent::PeerInfo &peer, bool &isNewPeer)
+void PeerListWidget::updatePeer(const BitTorrent::TorrentHandle *torrent, const BitTorrent::PeerInfo &peer, const QString &country, bool &isNewPeer)
 {
     const PeerEndpoint peerEndpoint {peer.address(), peer.connectionType()};
     const QString peerIp = peerEndpoint.address.ip.toString();
@@ -417,10 +428,10 @@ void PeerListWidget::updatePeer(const BitTorrent::TorrentHandle *torrent, const
         m_resolver->resolve(peerEndpoint.address.ip);
 
     if (m_resolveCountries) {
-        const QIcon icon = UIThemeManager::instance()->getFlagIcon(peer.country());
+        const QIcon icon = UIThemeManager::instance()->getFlagIcon(country);
         if (!icon.isNull()) {
             m_listModel->setData(m_listModel->index(row, PeerListDelegate::COUNTRY), icon, Qt::DecorationRole);
-            const QString countryName = Net::GeoIPManager::CountryName(peer.country());
+            const QString countryName = Net::GeoIPManager::CountryName(country);
             m_listModel->setData(m_listModel->index(row, PeerListDelegate::COUNTRY), countryName, Qt::ToolTipRole);
         }
     }
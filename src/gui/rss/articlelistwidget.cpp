@@ -43,6 +43,12 @@ ArticleListWidget::ArticleListWidget(QWidget *parent)
     checkInvariant();
 }
 
+ArticleListWidget::~ArticleListWidget()
+{
+    if (m_rssItem)
+        m_rssItem->unpinArticles();
+}
+
 RSS::Article *ArticleListWidget::getRSSArticle(QListWidgetItem *item) const
 {
     Q_ASSERT(item);
@@ -59,12 +65,16 @@ void ArticleListWidget::setRSSItem(RSS::Item *rssItem, bool unreadOnly)
     // Clear the list first
     clear();
     m_rssArticleToListItemMapping.clear();
-    if (m_rssItem)
+    if (m_rssItem) {
         m_rssItem->disconnect(this);
+        m_rssItem->unpinArticles();
+    }
 
     m_unreadOnly = unreadOnly;
     m_rssItem = rssItem;
     if (m_rssItem) {
+        // displayed articles must not be unloaded
+        m_rssItem->pinArticles();
         connect(m_rssItem, &RSS::Item::newArticle, this, &ArticleListWidget::handleArticleAdded);
         connect(m_rssItem, &RSS::Item::articleRead, this, &ArticleListWidget::handleArticleRead);
         connect(m_rssItem, &RSS::Item::articleAboutToBeRemoved, this, &ArticleListWidget::handleArticleAboutToBeRemoved);
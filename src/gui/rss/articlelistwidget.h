@@ -31,6 +31,7 @@
 
 #include <QHash>
 #include <QListWidget>
+#include <QPointer>
 
 namespace RSS
 {
@@ -44,6 +45,7 @@ class ArticleListWidget : public QListWidget
 
 public:
     explicit ArticleListWidget(QWidget *parent);
+    ~ArticleListWidget() override;
 
     RSS::Article *getRSSArticle(QListWidgetItem *item) const;
     QListWidgetItem *mapRSSArticle(RSS::Article *rssArticle) const;
@@ -59,7 +61,7 @@ private:
     void checkInvariant() const;
     QListWidgetItem *createItem(RSS::Article *article) const;
 
-    RSS::Item *m_rssItem = nullptr;
+    QPointer<RSS::Item> m_rssItem;
     bool m_unreadOnly = false;
     QHash<RSS::Article *, QListWidgetItem *> m_rssArticleToListItemMapping;
 };
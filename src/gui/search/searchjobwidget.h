@@ -36,11 +36,11 @@
 
 class QHeaderView;
 class QModelIndex;
-class QStandardItemModel;
 
 class LineEdit;
 class SearchHandler;
 class SearchListDelegate;
+class SearchListModel;
 class SearchSortModel;
 struct SearchResult;
 
@@ -122,7 +122,7 @@ private:
 
     Ui::SearchJobWidget *m_ui;
     SearchHandler *m_searchHandler;
-    QStandardItemModel *m_searchListModel;
+    SearchListModel *m_searchListModel;
     SearchSortModel *m_proxyModel;
     SearchListDelegate *m_searchDelegate;
     LineEdit *m_lineEditSearchResultsFilter;
@@ -0,0 +1,161 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2020  Eugene Shalygin <eugene.shalygin@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "searchlistmodel.h"
+
+#include "base/search/searchresultstore.h"
+#include "searchsortmodel.h"
+
+SearchListModel::SearchListModel(const SearchResultStore &results, QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_results(results)
+    , m_rowCount(results.size())
+{
+}
+
+int SearchListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rowCount;
+}
+
+int SearchListModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : SearchSortModel::NB_SEARCH_COLUMNS;
+}
+
+QVariant SearchListModel::data(const QModelIndex &index, const int role) const
+{
+    if (!index.isValid() || (index.row() >= m_rowCount))
+        return {};
+
+    const int row = index.row();
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+        switch (index.column()) {
+        case SearchSortModel::NAME:
+            return m_results.fileName(row);
+        case SearchSortModel::SIZE:
+            return m_results.fileSize(row);
+        case SearchSortModel::SEEDS:
+            return m_results.nbSeeders(row);
+        case SearchSortModel::LEECHES:
+            return m_results.nbLeechers(row);
+        case SearchSortModel::ENGINE_URL:
+            return m_results.siteUrl(row);
+        case SearchSortModel::DL_LINK:
+            return m_results.fileUrl(row);
+        case SearchSortModel::DESC_LINK:
+            return m_results.descrLink(row);
+        default:
+            return {};
+        }
+    case Qt::ForegroundRole: {
+            const auto colorIter = m_rowColors.constFind(row);
+            if (colorIter != m_rowColors.cend())
+                return colorIter.value();
+        }
+        break;
+    }
+
+    return {};
+}
+
+QVariant SearchListModel::headerData(const int section, const Qt::Orientation orientation, const int role) const
+{
+    if (orientation != Qt::Horizontal)
+        return {};
+
+    if (role == Qt::DisplayRole) {
+        switch (section) {
+        case SearchSortModel::NAME:
+            return tr("Name", "i.e: file name");
+        case SearchSortModel::SIZE:
+            return tr("Size", "i.e: file size");
+        case SearchSortModel::SEEDS:
+            return tr("Seeders", "i.e: Number of full sources");
+        case SearchSortModel::LEECHES:
+            return tr("Leechers", "i.e: Number of partial sources");
+        case SearchSortModel::ENGINE_URL:
+            return tr("Search engine");
+        default:
+            return {};
+        }
+    }
+
+    if (role == Qt::TextAlignmentRole) {
+        switch (section) {
+        case SearchSortModel::SIZE:
+        case SearchSortModel::SEEDS:
+        case SearchSortModel::LEECHES:
+            return QVariant(Qt::AlignRight | Qt::AlignVCenter);
+        default:
+            return {};
+        }
+    }
+
+    return {};
+}
+
+bool SearchListModel::setData(const QModelIndex &index, const QVariant &value, const int role)
+{
+    // Results are read only, only the row colors can be changed
+    if (!index.isValid() || (role != Qt::ForegroundRole))
+        return false;
+
+    m_rowColors[index.row()] = value.value<QColor>();
+    emit dataChanged(index, index, {role});
+    return true;
+}
+
+const SearchResultStore &SearchListModel::results() const
+{
+    return m_results;
+}
+
+void SearchListModel::updateResults()
+{
+    const int oldRowCount = m_rowCount;
+    const int newRowCount = m_results.size();
+
+    if (newRowCount > oldRowCount) {
+        beginInsertRows({}, oldRowCount, (newRowCount - 1));
+        m_rowCount = newRowCount;
+        endInsertRows();
+    }
+}
+
+void SearchListModel::updateResultStatistics(const QVector<int> &rows)
+{
+    for (const int row : rows) {
+        if (row >= m_rowCount)
+            continue;
+
+        emit dataChanged(index(row, SearchSortModel::SEEDS), index(row, SearchSortModel::LEECHES), {Qt::DisplayRole});
+    }
+}
@@ -29,7 +29,9 @@
 #include "searchsortmodel.h"
 
 #include "base/global.h"
+#include "base/search/searchresultstore.h"
 #include "base/utils/string.h"
+#include "searchlistmodel.h"
 
 SearchSortModel::SearchSortModel(QObject *parent)
     : base(parent)
@@ -110,8 +112,15 @@ qint64 SearchSortModel::maxSize() const
 
 bool SearchSortModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
 {
+    // Results are already kept sorted by the store so only their positions are compared
+    const auto *listModel = qobject_cast<const SearchListModel *>(sourceModel());
+
     switch (sortColumn()) {
     case NAME:
+        if (listModel)
+            return (listModel->results().rank(SearchResultStore::SortKey::Name, left.row())
+                    < listModel->results().rank(SearchResultStore::SortKey::Name, right.row()));
+        [[fallthrough]];
     case ENGINE_URL: {
             const QString strL = left.data().toString();
             const QString strR = right.data().toString();
@@ -119,6 +128,16 @@ bool SearchSortModel::lessThan(const QModelIndex &left, const QModelIndex &right
             return (result < 0);
         }
         break;
+    case SIZE:
+        if (listModel)
+            return (listModel->results().rank(SearchResultStore::SortKey::Size, left.row())
+                    < listModel->results().rank(SearchResultStore::SortKey::Size, right.row()));
+        return base::lessThan(left, right);
+    case SEEDS:
+        if (listModel)
+            return (listModel->results().rank(SearchResultStore::SortKey::Seeders, left.row())
+                    < listModel->results().rank(SearchResultStore::SortKey::Seeders, right.row()));
+        return base::lessThan(left, right);
     default:
         return base::lessThan(left, right);
     };
@@ -40,6 +40,7 @@
 #include "base/bittorrent/torrentinfo.h"
 #include "base/global.h"
 #include "base/utils/fs.h"
+#include "base/utils/misc.h"
 #include "ui_torrentcreatordialog.h"
 #include "utils.h"
 
@@ -62,6 +63,7 @@ TorrentCreatorDialog::TorrentCreatorDialog(QWidget *parent, const QString &defau
     , m_storeComments(SETTINGS_KEY("Comments"))
     , m_storeLastSavePath(SETTINGS_KEY("LastSavePath"), QDir::homePath())
     , m_storeSource(SETTINGS_KEY("Source"))
+    , m_hashingThreads(SETTINGS_KEY("HashingThreads"), 0)
 {
     m_ui->setupUi(this);
     setAttribute(Qt::WA_DeleteOnClose);
@@ -77,6 +79,7 @@ TorrentCreatorDialog::TorrentCreatorDialog(QWidget *parent, const QString &defau
     connect(m_creatorThread, &BitTorrent::TorrentCreatorThread::creationSuccess, this, &TorrentCreatorDialog::handleCreationSuccess);
     connect(m_creatorThread, &BitTorrent::TorrentCreatorThread::creationFailure, this, &TorrentCreatorDialog::handleCreationFailure);
     connect(m_creatorThread, &BitTorrent::TorrentCreatorThread::updateProgress, this, &TorrentCreatorDialog::updateProgressBar);
+    connect(m_creatorThread, &BitTorrent::TorrentCreatorThread::updateSpeed, this, &TorrentCreatorDialog::updateHashingSpeed);
 
     loadSettings();
     updateInputPath(defaultPath);
@@ -180,6 +183,7 @@ void TorrentCreatorDialog::onCreateButtonClicked()
         , m_ui->lineEditSource->text()
         , trackers
         , m_ui->URLSeedsList->toPlainText().split('\n', QString::SkipEmptyParts)
+        , m_hashingThreads
     };
 
     // run the creator thread
@@ -222,6 +226,13 @@ void TorrentCreatorDialog::handleCreationSuccess(const QString &path, const QStr
 void TorrentCreatorDialog::updateProgressBar(int progress)
 {
     m_ui->progressBar->setValue(progress);
+    if (progress == 0)
+        m_ui->progressBar->resetFormat();
+}
+
+void TorrentCreatorDialog::updateHashingSpeed(const qint64 speed)
+{
+    m_ui->progressBar->setFormat(QString::fromLatin1("%p% (%1)").arg(Utils::Misc::friendlyUnit(speed, true)));
 }
 
 void TorrentCreatorDialog::updatePiecesCount()
@@ -55,6 +55,7 @@ public:
 
 private slots:
     void updateProgressBar(int progress);
+    void updateHashingSpeed(qint64 speed);
     void updatePiecesCount();
     void onCreateButtonClicked();
     void onAddFileButtonClicked();
@@ -90,6 +91,7 @@ private:
     CachedSettingValue<QString> m_storeComments;
     CachedSettingValue<QString> m_storeLastSavePath;
     CachedSettingValue<QString> m_storeSource;
+    CachedSettingValue<int> m_hashingThreads;
 };
 
 #endif // TORRENTCREATORDIALOG_H
@@ -1,4 +1,4 @@
-#VERSION: 1.43
+#VERSION: 1.46
 
 # Author:
 #  Fabien Devaux <fab AT gnux DOT info>
@@ -33,11 +33,15 @@
 # ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 # POSSIBILITY OF SUCH DAMAGE.
 
+import time
 import urllib.parse
 from os import path
 from glob import glob
-from sys import argv
-from multiprocessing import Pool, cpu_count
+from sys import argv, stdin
+from threading import Lock
+from multiprocessing import Array, Pool, cpu_count
+
+import novaprinter
 
 THREADED = True
 try:
@@ -45,6 +49,10 @@ try:
 except NotImplementedError:
     MAX_THREADS = 1
 
+# searches which aren't finished in time (seconds) after stdin of the worker is closed
+# are supposed to hang
+WORKER_EXIT_TIMEOUT = 170
+
 CATEGORIES = {'all', 'movies', 'tv', 'music', 'games', 'anime', 'software', 'pictures', 'books'}
 
 ################################################################################
@@ -142,6 +150,94 @@ def run_search(engine_list):
         return False
 
 
+def init_worker_process(cancelled):
+    """ Initialize search process of the worker pool """
+    global cancelled_searches
+    cancelled_searches = cancelled
+
+
+def run_worker_search(search_params):
+    """ Run search in engine on behalf of the worker
+
+        @param search_params List with search ID, engine, query and category
+    """
+    search_id, engine, what, cat = search_params
+    # skip the searches cancelled while they were waiting in the queue
+    if search_id in cancelled_searches[:]:
+        return True
+
+    # results are tagged with search ID so they can be told apart
+    novaprinter.search_id = search_id
+    return run_search([engine, what, cat])
+
+
+def run_worker(supported_engines):
+    """ Serve search requests until stdin is closed, then wait for the searches
+        in progress, but terminate the ones that take too long (i.e. hung plugins)
+
+        Requests are read from stdin, one per line:
+            search<TAB>id<TAB>engine1[,engine2]*<TAB>category<TAB>keywords
+            cancel<TAB>id
+        Responses are written to stdout, one per line:
+            result<TAB>id<TAB>result line (see novaprinter)
+        or, if framed output is requested, results are written as frames
+        tagged with search ID (see novaprinter)
+            finished<TAB>id<TAB>1 if all engines succeeded, 0 otherwise
+    """
+    output_lock = Lock()
+
+    def write_message(*fields):
+        with output_lock:
+            with open(1, 'w', encoding='utf-8', closefd=False) as utf8stdout:
+                print("\t".join(fields), file=utf8stdout, flush=True)
+
+    # IDs of cancelled searches are shared with search processes
+    cancelled = Array('q', 64)
+    cancelled_count = 0
+    pending_searches = []
+
+    with Pool(MAX_THREADS, init_worker_process, (cancelled,)) as pool:
+        for line in stdin:
+            request = line.rstrip('\r\n').split('\t')
+            if (len(request) == 2) and (request[0] == 'cancel'):
+                cancelled[cancelled_count % len(cancelled)] = int(request[1])
+                cancelled_count += 1
+                continue
+
+            if (len(request) != 5) or (request[0] != 'search'):
+                continue
+
+            search_id = int(request[1])
+            engines_list = set(e.lower() for e in request[2].strip().split(','))
+            if 'all' in engines_list:
+                engines_list = supported_engines
+            else:
+                engines_list = [engine for engine in engines_list
+                                if engine in supported_engines]
+
+            cat = request[3].lower()
+            if (not engines_list) or (cat not in CATEGORIES):
+                write_message('finished', str(search_id), '1' if not engines_list else '0')
+                continue
+
+            what = urllib.parse.quote(request[4])
+            pending_searches = [search for search in pending_searches if not search.ready()]
+            search = pool.map_async(run_worker_search
+                                    , [(search_id, globals()[engine], what, cat) for engine in engines_list]
+                                    , callback=(lambda results, search_id=search_id:
+                                                write_message('finished', str(search_id), '1' if all(results) else '0'))
+                                    , error_callback=(lambda error, search_id=search_id:
+                                                      write_message('finished', str(search_id), '0')))
+            pending_searches.append(search)
+
+        # let the searches in progress finish, the pool is terminated
+        # (along with the hung searches) on leaving this block
+        pool.close()
+        deadline = time.monotonic() + WORKER_EXIT_TIMEOUT
+        for search in pending_searches:
+            search.wait(max(0, deadline - time.monotonic()))
+
+
 def main(args):
     supported_engines = initialize_engines()
 
@@ -153,6 +249,10 @@ def main(args):
         displayCapabilities(supported_engines)
         return
 
+    elif args[0] == "--worker":
+        run_worker(supported_engines)
+        return
+
     elif len(args) < 3:
         raise SystemExit("./nova2.py [all|engine1[,engine2]*] <category> <keywords>\n"
                          "available engines: %s" % (','.join(supported_engines)))
@@ -1,4 +1,4 @@
-#VERSION: 1.46
+#VERSION: 1.49
 
 # Redistribution and use in source and binary forms, with or without
 # modification, are permitted provided that the following conditions are met:
@@ -25,13 +25,97 @@
 # POSSIBILITY OF SUCH DAMAGE.
 
 
+import os
+import re
+import struct
+import sys
+
+# ID of the search the results belong to, it is set when running in nova2 worker mode
+search_id = None
+
+# qBittorrent asks for the results in length-prefixed frames with typed fields
+# so they don't need to be split and escaped. Frame layout (big-endian):
+#   0x1E 'R' <uint32 body size> <body>
+# Body fields are either 'I' <int64> or 'S' <uint32 size> <UTF-8 data>
+framed_output = (os.environ.get('QBT_SEARCH_FRAMED_OUTPUT') == '1')
+
+# Writes up to PIPE_BUF bytes are atomic, so frames of the search processes
+# sharing the same stdout pipe aren't mixed as long as they fit into it
+try:
+    import select
+    MAX_FRAME_SIZE = select.PIPE_BUF
+except (ImportError, AttributeError):
+    MAX_FRAME_SIZE = 4096
+
+
+def frameInt(value):
+    try:
+        value = int(value)
+    except (TypeError, ValueError):
+        value = -1
+    return b'I' + struct.pack('>q', value)
+
+
+def frameString(value):
+    data = str(value).strip().encode('utf-8')
+    return b'S' + struct.pack('>I', len(data)) + data
+
+
+def framedResult(dictionary):
+    def build():
+        fields = [frameInt(search_id if search_id is not None else 0),
+                  frameString(link), frameString(name),
+                  frameInt(dictionary["size"]), frameInt(dictionary["seeds"]),
+                  frameInt(dictionary["leech"]), frameString(dictionary["engine_url"])]
+        if desc_link is not None:
+            fields.append(frameString(desc_link))
+        body = b''.join(fields)
+        return b'\x1eR' + struct.pack('>I', len(body)) + body
+
+    link = str(dictionary["link"]).strip()
+    name = str(dictionary["name"]).strip()
+    desc_link = dictionary.get("desc_link")
+    frame = build()
+
+    # too large frame is shrunk: description link is optional, magnet link
+    # still works without trackers and the name is truncated at last
+    if len(frame) > MAX_FRAME_SIZE:
+        desc_link = None
+        frame = build()
+    if (len(frame) > MAX_FRAME_SIZE) and link.startswith('magnet:'):
+        link = re.sub(r'&tr=[^&]*', '', link)
+        frame = build()
+    if len(frame) > MAX_FRAME_SIZE:
+        name_data = name.encode('utf-8')
+        name_data = name_data[:max(0, len(name_data) - (len(frame) - MAX_FRAME_SIZE))]
+        name = name_data.decode('utf-8', 'ignore')
+        frame = build()
+
+    return frame if (len(frame) <= MAX_FRAME_SIZE) else None
+
+
 def prettyPrinter(dictionary):
     dictionary['size'] = anySizeToBytes(dictionary['size'])
+
+    if framed_output:
+        frame = framedResult(dictionary)
+        if frame is None:
+            print("Result is too large to be reported: " + str(dictionary["link"])[:100], file=sys.stderr)
+            return
+
+        # fd 1 is stdout, single write of the frame isn't mixed with output of other processes
+        written = 0
+        while written < len(frame):
+            written += os.write(1, frame[written:])
+        return
+
     outtext = "|".join((dictionary["link"], dictionary["name"].replace("|", " "),
                         str(dictionary["size"]), str(dictionary["seeds"]),
                         str(dictionary["leech"]), dictionary["engine_url"]))
     if 'desc_link' in dictionary:
         outtext = "|".join((outtext, dictionary["desc_link"]))
+    if search_id is not None:
+        outtext = "\t".join(("result", str(search_id), outtext))
 
     # fd 1 is stdout
     with open(1, 'w', encoding='utf-8', closefd=False) as utf8stdout:
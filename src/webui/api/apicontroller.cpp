@@ -86,6 +86,11 @@ void APIController::setResult(const QString &result)
     m_result = result;
 }
 
+void APIController::setResult(const QByteArray &result)
+{
+    m_result = result;
+}
+
 void APIController::setResult(const QJsonArray &result)
 {
     m_result = QJsonDocument(result);
@@ -63,6 +63,7 @@ protected:
     void requireParams(const QVector<QString> &requiredParams) const;
 
     void setResult(const QString &result);
+    void setResult(const QByteArray &result);
     void setResult(const QJsonArray &result);
     void setResult(const QJsonObject &result);
 
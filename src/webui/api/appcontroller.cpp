@@ -46,6 +46,7 @@
 #include <QTranslator>
 
 #include "base/bittorrent/session.h"
+#include "base/bittorrent/torrentcreationmanager.h"
 #include "base/global.h"
 #include "base/net/portforwarder.h"
 #include "base/net/proxyconfigurationmanager.h"
@@ -53,6 +54,7 @@
 #include "base/rss/rss_autodownloader.h"
 #include "base/rss/rss_session.h"
 #include "base/scanfoldersmodel.h"
+#include "base/search/searchpluginmanager.h"
 #include "base/torrentfileguard.h"
 #include "base/utils/fs.h"
 #include "base/utils/misc.h"
@@ -258,6 +260,15 @@ void AppController::preferencesAction()
     data["rss_processing_enabled"] = RSS::Session::instance()->isProcessingEnabled();
     data["rss_auto_downloading_enabled"] = RSS::AutoDownloader::instance()->isProcessingEnabled();
 
+    // Torrent creator settings
+    data["torrent_creator_max_active_tasks"] = BitTorrent::TorrentCreationManager::instance()->maxActiveTasks();
+    data["torrent_creator_max_active_tasks_per_disk"] = BitTorrent::TorrentCreationManager::instance()->maxActiveTasksPerDisk();
+
+    // Search settings
+    data["search_result_cache_ttl"] = SearchPluginManager::instance()->resultCacheTTL();
+    data["search_result_cache_size"] = SearchPluginManager::instance()->resultCacheSize();
+    data["search_result_cache_refresh_enabled"] = SearchPluginManager::instance()->isResultCacheRefreshEnabled();
+
     // Advanced settings
     // qBitorrent preferences
     // Current network interface
@@ -305,6 +316,9 @@ void AppController::preferencesAction()
     // Embedded tracker
     data["enable_embedded_tracker"] = session->isTrackerEnabled();
     data["embedded_tracker_port"] = pref->getTrackerPort();
+    data["embedded_tracker_udp_port"] = pref->getTrackerUDPPort();
+    data["embedded_tracker_max_torrents"] = pref->getTrackerMaxTorrents();
+    data["embedded_tracker_max_peers_per_torrent"] = pref->getTrackerMaxPeersPerTorrent();
     // Choking algorithm
     data["upload_slots_behavior"] = static_cast<int>(session->chokingAlgorithm());
     // Seed choking algorithm
@@ -646,6 +660,20 @@ void AppController::setPreferencesAction()
     if (hasKey("rss_auto_downloading_enabled"))
         RSS::AutoDownloader::instance()->setProcessingEnabled(it.value().toBool());
 
+    // Torrent creator settings
+    if (hasKey("torrent_creator_max_active_tasks"))
+        BitTorrent::TorrentCreationManager::instance()->setMaxActiveTasks(it.value().toInt());
+    if (hasKey("torrent_creator_max_active_tasks_per_disk"))
+        BitTorrent::TorrentCreationManager::instance()->setMaxActiveTasksPerDisk(it.value().toInt());
+
+    // Search settings
+    if (hasKey("search_result_cache_ttl"))
+        SearchPluginManager::instance()->setResultCacheTTL(it.value().toInt());
+    if (hasKey("search_result_cache_size"))
+        SearchPluginManager::instance()->setResultCacheSize(it.value().toInt());
+    if (hasKey("search_result_cache_refresh_enabled"))
+        SearchPluginManager::instance()->setResultCacheRefreshEnabled(it.value().toBool());
+
     // Advanced settings
     // qBittorrent preferences
     // Current network interface
@@ -728,6 +756,16 @@ void AppController::setPreferencesAction()
     // Embedded tracker
     if (hasKey("embedded_tracker_port"))
         pref->setTrackerPort(it.value().toInt());
+    if (hasKey("embedded_tracker_udp_port")) {
+        // 0 disables UDP announces
+        const int port = it.value().toInt();
+        if ((port >= 0) && (port <= 65535))
+            pref->setTrackerUDPPort(port);
+    }
+    if (hasKey("embedded_tracker_max_torrents"))
+        pref->setTrackerMaxTorrents(std::max(1, it.value().toInt()));
+    if (hasKey("embedded_tracker_max_peers_per_torrent"))
+        pref->setTrackerMaxPeersPerTorrent(std::max(1, it.value().toInt()));
     if (hasKey("enable_embedded_tracker"))
         session->setTrackerEnabled(it.value().toBool());
     // Choking algorithm
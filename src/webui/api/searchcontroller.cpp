@@ -28,6 +28,7 @@
 
 #include "searchcontroller.h"
 
+#include <algorithm>
 #include <limits>
 
 #include <QJsonArray>
@@ -142,13 +143,34 @@ void SearchController::statusAction()
         statusArray << QJsonObject {
             {"id", searchId},
             {"status", searchHandler->isActive() ? "Running" : "Stopped"},
-            {"total", searchHandler->results().size()}
+            {"total", searchHandler->results().size()},
+            {"cached", searchHandler->isCached()}
         };
     }
 
     setResult(statusArray);
 }
 
+// Returns the statistics of the search result cache
+void SearchController::cacheStatsAction()
+{
+    const SearchPluginManager *const pluginManager = SearchPluginManager::instance();
+    const QJsonObject result = {
+        {"hits", pluginManager->resultCacheHits()},
+        {"misses", pluginManager->resultCacheMisses()},
+        {"count", pluginManager->resultCacheCount()}
+    };
+
+    setResult(result);
+}
+
+// Returns the results of the search
+//   The following parameters are supported:
+//   - id (int): the search ID
+//   - limit (int): limit the number of results
+//   - offset (int): set offset (if less than 0 - offset from end)
+//   - sort (string): sort results by given key ("fileName", "fileSize" or "nbSeeders")
+//   - reverse (bool): enable reverse sorting
 void SearchController::resultsAction()
 {
     requireParams({"id"});
@@ -156,13 +178,15 @@ void SearchController::resultsAction()
     const int id = params()["id"].toInt();
     int limit = params()["limit"].toInt();
     int offset = params()["offset"].toInt();
+    const QString sortedColumn = params()["sort"];
+    const bool reverse = Utils::String::parseBool(params()["reverse"], false);
 
     const auto searchHandlers = sessionManager()->session()->getData<SearchHandlerDict>(SEARCH_HANDLERS);
     if (!searchHandlers.contains(id))
         throw APIError(APIErrorType::NotFound);
 
     const SearchHandlerPtr searchHandler = searchHandlers[id];
-    const QList<SearchResult> searchResults = searchHandler->results();
+    const SearchResultStore &searchResults = searchHandler->results();
     const int size = searchResults.size();
 
     if (offset > size)
@@ -176,10 +200,28 @@ void SearchController::resultsAction()
     if (limit <= 0)
         limit = -1;
 
-    if ((limit > 0) || (offset > 0))
-        setResult(getResults(searchResults.mid(offset, limit), searchHandler->isActive(), size));
-    else
-        setResult(getResults(searchResults, searchHandler->isActive(), size));
+    QVector<int> rows;
+    if (sortedColumn.isEmpty()) {
+        const int end = (limit > 0) ? std::min(size, (offset + limit)) : size;
+        rows.reserve(end - offset);
+        for (int row = offset; row < end; ++row)
+            rows.append(row);
+    }
+    else {
+        SearchResultStore::SortKey sortKey;
+        if (sortedColumn == QLatin1String("fileName"))
+            sortKey = SearchResultStore::SortKey::Name;
+        else if (sortedColumn == QLatin1String("fileSize"))
+            sortKey = SearchResultStore::SortKey::Size;
+        else if (sortedColumn == QLatin1String("nbSeeders"))
+            sortKey = SearchResultStore::SortKey::Seeders;
+        else
+            throw APIError(APIErrorType::BadParams, tr("Unsupported sort key"));
+
+        rows = searchResults.sortedRows(sortKey, reverse, offset, limit);
+    }
+
+    setResult(getResults(searchResults, rows, searchHandler->isActive(), size));
 }
 
 void SearchController::deleteAction()
@@ -314,18 +356,18 @@ int SearchController::generateSearchId() const
  *   - "siteUrl"
  *   - "descrLink"
  */
-QJsonObject SearchController::getResults(const QList<SearchResult> &searchResults, const bool isSearchActive, const int totalResults) const
+QJsonObject SearchController::getResults(const SearchResultStore &searchResults, const QVector<int> &rows, const bool isSearchActive, const int totalResults) const
 {
     QJsonArray searchResultsArray;
-    for (const SearchResult &searchResult : searchResults) {
+    for (const int row : rows) {
         searchResultsArray << QJsonObject {
-            {"fileName", searchResult.fileName},
-            {"fileUrl", searchResult.fileUrl},
-            {"fileSize", searchResult.fileSize},
-            {"nbSeeders", searchResult.nbSeeders},
-            {"nbLeechers", searchResult.nbLeechers},
-            {"siteUrl", searchResult.siteUrl},
-            {"descrLink", searchResult.descrLink}
+            {"fileName", searchResults.fileName(row)},
+            {"fileUrl", searchResults.fileUrl(row)},
+            {"fileSize", searchResults.fileSize(row)},
+            {"nbSeeders", searchResults.nbSeeders(row)},
+            {"nbLeechers", searchResults.nbLeechers(row)},
+            {"siteUrl", searchResults.siteUrl(row)},
+            {"descrLink", searchResults.descrLink(row)}
         };
     }
 
@@ -29,7 +29,7 @@
 #pragma once
 
 #include <QHash>
-#include <QList>
+#include <QVector>
 
 #include "base/search/searchpluginmanager.h"
 #include "apicontroller.h"
@@ -39,7 +39,7 @@ class QJsonObject;
 class QStringList;
 
 struct ISession;
-struct SearchResult;
+class SearchResultStore;
 
 class SearchController : public APIController
 {
@@ -54,6 +54,7 @@ private slots:
     void stopAction();
     void statusAction();
     void resultsAction();
+    void cacheStatsAction();
     void deleteAction();
     void categoriesAction();
     void pluginsAction();
@@ -70,6 +71,6 @@ private:
     void searchFinished(ISession *session, int id);
     void searchFailed(ISession *session, int id);
     int generateSearchId() const;
-    QJsonObject getResults(const QList<SearchResult> &searchResults, bool isSearchActive, int totalResults) const;
+    QJsonObject getResults(const SearchResultStore &searchResults, const QVector<int> &rows, bool isSearchActive, int totalResults) const;
     QJsonArray getPluginsInfo(const QStringList &plugins) const;
 };
@@ -43,6 +43,7 @@
 #include "base/global.h"
 #include "base/net/geoipmanager.h"
 #include "base/preferences.h"
+#include "base/rss/rss_autodownloader.h"
 #include "base/utils/string.h"
 #include "apierror.h"
 #include "freediskspacechecker.h"
@@ -86,7 +87,11 @@ namespace
     const char KEY_TRANSFER_DLDATA[] = "dl_info_data";
     const char KEY_TRANSFER_DLRATELIMIT[] = "dl_rate_limit";
     const char KEY_TRANSFER_DLSPEED[] = "dl_info_speed";
+    const char KEY_TRANSFER_EMBEDDED_TRACKER_PEERS[] = "embedded_tracker_peers";
+    const char KEY_TRANSFER_EMBEDDED_TRACKER_TORRENTS[] = "embedded_tracker_torrents";
     const char KEY_TRANSFER_FREESPACEONDISK[] = "free_space_on_disk";
+    const char KEY_TRANSFER_RSS_AUTODOWNLOADER_QUEUE[] = "rss_autodownloader_queue";
+    const char KEY_TRANSFER_RSS_AUTODOWNLOADER_THROUGHPUT[] = "rss_autodownloader_throughput";
     const char KEY_TRANSFER_UPDATA[] = "up_info_data";
     const char KEY_TRANSFER_UPRATELIMIT[] = "up_rate_limit";
     const char KEY_TRANSFER_UPSPEED[] = "up_info_speed";
@@ -155,6 +160,12 @@ namespace
         map[KEY_TRANSFER_TOTAL_QUEUED_SIZE] = cacheStatus.queuedBytes;
 
         map[KEY_TRANSFER_DHT_NODES] = sessionStatus.dhtNodes;
+        map[KEY_TRANSFER_EMBEDDED_TRACKER_TORRENTS] = session->trackerTorrentsCount();
+        map[KEY_TRANSFER_EMBEDDED_TRACKER_PEERS] = session->trackerPeersCount();
+        if (const auto *autoDownloader = RSS::AutoDownloader::instance()) {
+            map[KEY_TRANSFER_RSS_AUTODOWNLOADER_QUEUE] = autoDownloader->processingQueueSize();
+            map[KEY_TRANSFER_RSS_AUTODOWNLOADER_THROUGHPUT] = Utils::String::fromDouble(autoDownloader->processingThroughput(), 1);
+        }
         map[KEY_TRANSFER_CONNECTION_STATUS] = session->isListening()
             ? (sessionStatus.hasIncomingConnections ? "connected" : "firewalled")
             : "disconnected";
@@ -505,7 +516,20 @@ void SyncController::torrentPeersAction()
 
     data[KEY_SYNC_TORRENT_PEERS_SHOW_FLAGS] = resolvePeerCountries;
 
-    for (const BitTorrent::PeerInfo &pi : peersList) {
+#ifndef DISABLE_COUNTRIES_RESOLUTION
+    // resolve all countries at once
+    QVector<QString> countries;
+    if (resolvePeerCountries) {
+        QVector<QHostAddress> addresses;
+        addresses.reserve(peersList.size());
+        for (const BitTorrent::PeerInfo &pi : peersList)
+            addresses.append(pi.address().ip);
+        countries = Net::GeoIPManager::instance()->lookup(addresses);
+    }
+#endif
+
+    for (int i = 0; i < peersList.size(); ++i) {
+        const BitTorrent::PeerInfo &pi = peersList[i];
         if (pi.address().ip.isNull()) continue;
 
         QVariantMap peer = {
@@ -526,8 +550,8 @@ void SyncController::torrentPeersAction()
 
 #ifndef DISABLE_COUNTRIES_RESOLUTION
         if (resolvePeerCountries) {
-            peer[KEY_PEER_COUNTRY_CODE] = pi.country().toLower();
-            peer[KEY_PEER_COUNTRY] = Net::GeoIPManager::CountryName(pi.country());
+            peer[KEY_PEER_COUNTRY_CODE] = countries[i].toLower();
+            peer[KEY_PEER_COUNTRY] = Net::GeoIPManager::CountryName(countries[i]);
         }
 #endif
 
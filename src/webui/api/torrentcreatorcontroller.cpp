@@ -0,0 +1,254 @@
+/*
+ * Bittorrent Client using Qt and libtorrent.
+ * Copyright (C) 2020  Eugene Shalygin <eugene.shalygin@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link this program with the OpenSSL project's "OpenSSL" library (or with
+ * modified versions of it that use the same license as the "OpenSSL" library),
+ * and distribute the linked executables. You must obey the GNU General Public
+ * License in all respects for all of the code used other than "OpenSSL".  If you
+ * modify file(s), you may extend this exception to your version of the file(s),
+ * but you are not obligated to do so. If you do not wish to do so, delete this
+ * exception statement from your version.
+ */
+
+#include "torrentcreatorcontroller.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include "base/bittorrent/torrentcreationmanager.h"
+#include "base/global.h"
+#include "base/utils/fs.h"
+#include "base/utils/string.h"
+#include "apierror.h"
+
+const char KEY_TASK_ID[] = "taskID";
+const char KEY_TASK_SOURCE_PATH[] = "sourcePath";
+const char KEY_TASK_TORRENT_FILE_PATH[] = "torrentFilePath";
+const char KEY_TASK_PIECE_SIZE[] = "pieceSize";
+const char KEY_TASK_PRIVATE[] = "private";
+const char KEY_TASK_STATUS[] = "status";
+const char KEY_TASK_PROGRESS[] = "progress";
+const char KEY_TASK_SPEED[] = "speed";
+const char KEY_TASK_ERROR_MESSAGE[] = "errorMessage";
+const char KEY_TASK_TIME_ADDED[] = "timeAdded";
+const char KEY_TASK_TIME_STARTED[] = "timeStarted";
+const char KEY_TASK_TIME_FINISHED[] = "timeFinished";
+
+namespace
+{
+    using BitTorrent::TorrentCreationTask;
+
+    QString statusString(const TorrentCreationTask::Status status)
+    {
+        switch (status) {
+        case TorrentCreationTask::Status::Queued:
+            return QLatin1String("Queued");
+        case TorrentCreationTask::Status::Running:
+            return QLatin1String("Running");
+        case TorrentCreationTask::Status::Finished:
+            return QLatin1String("Finished");
+        case TorrentCreationTask::Status::Failed:
+            return QLatin1String("Failed");
+        case TorrentCreationTask::Status::Cancelled:
+            return QLatin1String("Cancelled");
+        }
+
+        return {};
+    }
+
+    qint64 timestamp(const QDateTime &dateTime)
+    {
+        return dateTime.isValid() ? dateTime.toSecsSinceEpoch() : -1;
+    }
+
+    QJsonObject serializeTask(const TorrentCreationTask &task)
+    {
+        return {
+            {KEY_TASK_ID, task.id},
+            {KEY_TASK_SOURCE_PATH, Utils::Fs::toNativePath(task.params.inputPath)},
+            {KEY_TASK_TORRENT_FILE_PATH, Utils::Fs::toNativePath(task.params.savePath)},
+            {KEY_TASK_PIECE_SIZE, task.params.pieceSize},
+            {KEY_TASK_PRIVATE, task.params.isPrivate},
+            {KEY_TASK_STATUS, statusString(task.status)},
+            {KEY_TASK_PROGRESS, task.progress},
+            {KEY_TASK_SPEED, task.speed},
+            {KEY_TASK_ERROR_MESSAGE, task.errorMessage},
+            {KEY_TASK_TIME_ADDED, timestamp(task.timeAdded)},
+            {KEY_TASK_TIME_STARTED, timestamp(task.timeStarted)},
+            {KEY_TASK_TIME_FINISHED, timestamp(task.timeFinished)}
+        };
+    }
+
+    int taskIDParam(const StringMap &params)
+    {
+        bool ok = false;
+        const int id = params.value(KEY_TASK_ID).toInt(&ok);
+        if (!ok)
+            throw APIError(APIErrorType::BadParams);
+
+        return id;
+    }
+
+    // Piece size must be a power of two not less than 16 KiB (0 means automatic)
+    bool isValidPieceSize(const int pieceSize)
+    {
+        if (pieceSize == 0)
+            return true;
+
+        return (pieceSize >= (16 * 1024)) && ((pieceSize & (pieceSize - 1)) == 0);
+    }
+}
+
+// Adds the torrent creation task to the queue
+// The return value is a dictionary with the "taskID" key.
+// POST params:
+//   - sourcePath (string): file or folder the torrent is created from
+//   - torrentFilePath (string): where to save the torrent file (default: profile directory)
+//   - pieceSize (int): piece size in bytes, a power of two not less than 16 KiB (default 0: automatic)
+//   - private (bool): create private torrent (default false)
+//   - optimizeAlignment (bool): optimize file alignment (default true)
+//   - paddedFileSizeLimit (int): pad only files larger than the limit in bytes (default -1: no limit)
+//   - trackers (string): tracker URLs separated by new lines, an empty line starts a new tier
+//   - urlSeeds (string): web seed URLs separated by new lines
+//   - comment (string): torrent comment
+//   - source (string): torrent source field
+//   - startSeeding (bool): add the created torrent to the session (default false)
+void TorrentCreatorController::addTaskAction()
+{
+    requireParams({KEY_TASK_SOURCE_PATH});
+
+    using Utils::String::parseBool;
+
+    const QString sourcePath = Utils::Fs::toUniformPath(params()[KEY_TASK_SOURCE_PATH].trimmed());
+    if (sourcePath.isEmpty() || !QFileInfo::exists(sourcePath))
+        throw APIError(APIErrorType::BadParams, tr("Source path doesn't exist"));
+
+    const QString torrentFilePath = Utils::Fs::toUniformPath(params()[KEY_TASK_TORRENT_FILE_PATH].trimmed());
+
+    int pieceSize = 0;
+    if (params().contains(KEY_TASK_PIECE_SIZE)) {
+        bool ok = false;
+        pieceSize = params()[KEY_TASK_PIECE_SIZE].toInt(&ok);
+        if (!ok || !isValidPieceSize(pieceSize))
+            throw APIError(APIErrorType::BadParams, tr("Invalid piece size"));
+    }
+
+    const BitTorrent::TorrentCreatorParams creatorParams {
+        parseBool(params()[KEY_TASK_PRIVATE], false)
+        , parseBool(params()["optimizeAlignment"], true)
+        , pieceSize
+        , (params().contains("paddedFileSizeLimit") ? params()["paddedFileSizeLimit"].toInt() : -1)
+        , QFileInfo(sourcePath).canonicalFilePath()
+        , torrentFilePath
+        , params()["comment"]
+        , params()["source"]
+        , params()["trackers"].trimmed().split('\n')
+        , params()["urlSeeds"].split('\n', QString::SkipEmptyParts)
+        , 0
+    };
+    const bool isSeedingEnabled = parseBool(params()["startSeeding"], false);
+
+    const int id = BitTorrent::TorrentCreationManager::instance()->addTask(creatorParams, isSeedingEnabled);
+    setResult(QJsonObject {{KEY_TASK_ID, id}});
+}
+
+// Returns the torrent creation tasks in JSON format.
+// The return value is an array of dictionaries.
+// The dictionary keys are:
+//   - "taskID": ID of the task
+//   - "sourcePath": file or folder the torrent is created from
+//   - "torrentFilePath": path of the torrent file
+//   - "pieceSize": piece size in bytes (0 if automatic)
+//   - "private": whether the torrent is private
+//   - "status": "Queued", "Running", "Finished", "Failed" or "Cancelled"
+//   - "progress": progress of piece hashing in percent
+//   - "speed": hashing speed in bytes per second
+//   - "errorMessage": reason of the failure
+//   - "timeAdded", "timeStarted", "timeFinished": seconds since epoch (-1 if not yet)
+// GET params:
+//   - taskID (int): return only the given task (default: all tasks)
+void TorrentCreatorController::statusAction()
+{
+    const BitTorrent::TorrentCreationManager *manager = BitTorrent::TorrentCreationManager::instance();
+
+    QJsonArray tasksArray;
+    if (params().contains(KEY_TASK_ID)) {
+        const TorrentCreationTask *task = manager->task(taskIDParam(params()));
+        if (!task)
+            throw APIError(APIErrorType::NotFound);
+
+        tasksArray << serializeTask(*task);
+    }
+    else {
+        for (const TorrentCreationTask &task : asConst(manager->tasks()))
+            tasksArray << serializeTask(task);
+    }
+
+    setResult(tasksArray);
+}
+
+// Cancels the queued or running task
+// POST params:
+//   - taskID (int): ID of the task
+void TorrentCreatorController::cancelTaskAction()
+{
+    requireParams({KEY_TASK_ID});
+
+    BitTorrent::TorrentCreationManager *manager = BitTorrent::TorrentCreationManager::instance();
+    const int id = taskIDParam(params());
+    if (!manager->task(id))
+        throw APIError(APIErrorType::NotFound);
+
+    if (!manager->cancelTask(id))
+        throw APIError(APIErrorType::Conflict, tr("Task is already finished"));
+}
+
+// Removes the task, it is cancelled if it's not finished yet.
+// Torrent file is removed only if it was saved to the profile directory.
+// POST params:
+//   - taskID (int): ID of the task
+void TorrentCreatorController::deleteTaskAction()
+{
+    requireParams({KEY_TASK_ID});
+
+    if (!BitTorrent::TorrentCreationManager::instance()->deleteTask(taskIDParam(params())))
+        throw APIError(APIErrorType::NotFound);
+}
+
+// Returns contents of the created torrent file
+// GET params:
+//   - taskID (int): ID of the task
+void TorrentCreatorController::torrentFileAction()
+{
+    requireParams({KEY_TASK_ID});
+
+    const TorrentCreationTask *task = BitTorrent::TorrentCreationManager::instance()->task(taskIDParam(params()));
+    if (!task)
+        throw APIError(APIErrorType::NotFound);
+    if (task->status != TorrentCreationTask::Status::Finished)
+        throw APIError(APIErrorType::Conflict, tr("Torrent creation is not finished"));
+
+    QFile file {task->params.savePath};
+    if (!file.open(QIODevice::ReadOnly))
+        throw APIError(APIErrorType::Conflict, tr("Unable to read torrent file"));
+
+    setResult(file.readAll());
+}
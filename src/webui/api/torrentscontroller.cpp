@@ -38,6 +38,7 @@
 #include <QNetworkCookie>
 #include <QRegularExpression>
 #include <QUrl>
+#include <QVector>
 
 #include "base/bittorrent/downloadpriority.h"
 #include "base/bittorrent/infohash.h"
@@ -581,15 +582,18 @@ void TorrentsController::addAction()
     params.downloadLimit = (dlLimit > 0) ? dlLimit : -1;
     params.useAutoTMM = autoTMM;
 
-    bool partialSuccess = false;
+    // Torrents are added in the background, so duplicates aren't reported here
+    QStringList sources;
     for (QString url : asConst(urls.split('\n'))) {
         url = url.trimmed();
         if (!url.isEmpty()) {
             Net::DownloadManager::instance()->setCookiesFromUrl(cookies, QUrl::fromEncoded(url.toUtf8()));
-            partialSuccess |= BitTorrent::Session::instance()->addTorrent(url, params);
+            sources << url;
         }
     }
 
+    QVector<BitTorrent::TorrentInfo> torrents;
+    torrents.reserve(data().size());
     for (auto it = data().constBegin(); it != data().constEnd(); ++it) {
         const BitTorrent::TorrentInfo torrentInfo = BitTorrent::TorrentInfo::load(it.value());
         if (!torrentInfo.isValid()) {
@@ -597,9 +601,13 @@ void TorrentsController::addAction()
                            , tr("Error: '%1' is not a valid torrent file.").arg(it.key()));
         }
 
-        partialSuccess |= BitTorrent::Session::instance()->addTorrent(torrentInfo, params);
+        torrents << torrentInfo;
     }
 
+    BitTorrent::Session::instance()->addTorrents(sources, params);
+    BitTorrent::Session::instance()->addTorrents(torrents, params);
+
+    const bool partialSuccess = (!sources.isEmpty() || !torrents.isEmpty());
     if (partialSuccess)
         setResult("Ok.");
     else
@@ -60,6 +60,7 @@
 #include "api/rsscontroller.h"
 #include "api/searchcontroller.h"
 #include "api/synccontroller.h"
+#include "api/torrentcreatorcontroller.h"
 #include "api/torrentscontroller.h"
 #include "api/transfercontroller.h"
 
@@ -124,6 +125,7 @@ WebApplication::WebApplication(QObject *parent)
     registerAPIController(QLatin1String("rss"), new RSSController(this, this));
     registerAPIController(QLatin1String("search"), new SearchController(this, this));
     registerAPIController(QLatin1String("sync"), new SyncController(this, this));
+    registerAPIController(QLatin1String("torrentcreator"), new TorrentCreatorController(this, this));
     registerAPIController(QLatin1String("torrents"), new TorrentsController(this, this));
     registerAPIController(QLatin1String("transfer"), new TransferController(this, this));
 
@@ -272,6 +274,9 @@ void WebApplication::doProcessRequest()
         case QMetaType::QJsonDocument:
             print(result.toJsonDocument().toJson(QJsonDocument::Compact), Http::CONTENT_TYPE_JSON);
             break;
+        case QMetaType::QByteArray:
+            print(result.toByteArray(), Http::CONTENT_TYPE_OCTET_STREAM);
+            break;
         case QMetaType::QString:
         default:
             print(result.toString(), Http::CONTENT_TYPE_TXT);
@@ -415,8 +420,8 @@ Http::Response WebApplication::processRequest(const Http::Request &request, cons
     m_params.clear();
 
     if (m_request.method == Http::METHOD_GET) {
-        for (auto iter = m_request.query.cbegin(); iter != m_request.query.cend(); ++iter)
-            m_params[iter.key()] = QString::fromUtf8(iter.value());
+        for (const QString &key : asConst(m_request.query.uniqueKeys()))
+            m_params[key] = QString::fromUtf8(m_request.query.value(key));
     }
     else {
         m_params = m_request.posts;